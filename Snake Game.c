@@ -15,9 +15,19 @@
  */
 
 #define _CRT_SECURE_NO_WARNINGS
+#define _WINSOCK_DEPRECATED_NO_WARNINGS // inet_addr is fine for LAN cabinet addressing
 #define _WIN32_WINNT 0x0500
 
+#include <winsock2.h> // Lockstep netplay transport; must precede windows.h
 #include <windows.h>
+#include <mmsystem.h> // timeBeginPeriod
+
+// Single-TU project: pull the extra Win32 link dependencies in right here
+// so the documented one-command build keeps working without a makefile
+#ifdef _MSC_VER
+#pragma comment(lib, "winmm.lib")  // timeBeginPeriod
+#pragma comment(lib, "ws2_32.lib") // Netplay and spectator sockets
+#endif
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
@@ -25,26 +35,146 @@
 #include <string.h>
 #include <math.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h> // SSE2 particle kernel
+#endif
+
 // ======================================================================================
 // CONFIGURATION & CONSTANTS
 // ======================================================================================
 
 #define APP_TITLE       "Snake Engine v1.0"
+
+// Board dimensions are compile-time constants so every index multiply
+// below constant-folds (arena strides become shifts). We ship exactly
+// two board sizes; cabinet builds select the large one with a single
+// translation-unit parameter: -DBOARD_CABINET.
+#ifdef BOARD_CABINET
+#define SCREEN_WIDTH    120
+#define SCREEN_HEIGHT   40
+#define ARENA_WIDTH     512
+#define ARENA_HEIGHT    512
+#define ARENA_SHIFT     9   // log2(ARENA_WIDTH): row stride as a shift
+#else
 #define SCREEN_WIDTH    80
 #define SCREEN_HEIGHT   30
+#define ARENA_WIDTH     256
+#define ARENA_HEIGHT    256
+#define ARENA_SHIFT     8
+#endif
+
+// World size is decoupled from the screen: the camera scrolls a
+// SCREEN_WIDTH x SCREEN_HEIGHT window over the arena. Both dimensions
+// must be multiples of CHUNK_SIZE and at least the screen size.
+#define ARENA_CELLS     (ARENA_WIDTH * ARENA_HEIGHT)
+#define CHUNK_SHIFT     5
+#define CHUNK_SIZE      (1 << CHUNK_SHIFT)  // 32x32 cells per map chunk
+#define CHUNK_MASK      (CHUNK_SIZE - 1)
+#define ARENA_CHUNKS_X  (ARENA_WIDTH / CHUNK_SIZE)
+#define ARENA_CHUNKS_Y  (ARENA_HEIGHT / CHUNK_SIZE)
+
+// Compile-time consistency guards (negative array size on violation)
+typedef char assert_arena_shift_matches[(1 << ARENA_SHIFT) == ARENA_WIDTH ? 1 : -1];
+typedef char assert_arena_chunk_aligned[(ARENA_WIDTH % CHUNK_SIZE == 0 &&
+                                         ARENA_HEIGHT % CHUNK_SIZE == 0) ? 1 : -1];
+
+// Shared index helpers for the hot paths. With the dimensions pinned
+// above, the arena stride is a shift and the screen stride folds into
+// the surrounding address math at compile time.
+static inline int Arena_Index(int x, int y) { return (y << ARENA_SHIFT) | x; }
+static inline int Screen_Index(int x, int y) { return y * SCREEN_WIDTH + x; }
 
 // Game Balance
 #define BASE_TICK_RATE  0.05    // 20 Ticks per second (Standard speed)
+#define FRAME_RATE_CAP  120     // Render/pacing budget: frames per second
 #define DASH_MULTIPLIER 2.0     // Speed multiplier when dashing
 #define COMBO_WINDOW    60      // Ticks allowed between eats to keep combo
 #define MAX_COMBO       4       // Maximum score multiplier
 
+// Speedrun mode: split times at the score thresholds that also recolor
+// the snake in Game_UpdateFixed
+#define SPEEDRUN_SPLITS 3
+
 // Memory Limits
 #define INPUT_QUEUE_SIZE 4
-#define MAX_SNAKE_LEN    2048
-#define MAX_PARTICLES    200
-#define MAX_SCORES       5
+#define KEY_EVENT_QUEUE_SIZE 64
+#define MAX_SNAKE_LEN    ARENA_CELLS   // Ring mask requires a power of two
+#define MAX_PARTICLES    4096
+
+// Particle physics (sub-cell, per tick). Console cells are ~2x taller
+// than wide, so vertical speeds are tuned smaller than horizontal ones.
+#define PARTICLE_GRAVITY 0.04f
+#define PARTICLE_DRAG    0.96f
+
+// Explicit SSE2 particle kernel. Auto-enabled where the target
+// guarantees SSE2; define PARTICLE_SSE2 0 to force the scalar loop.
+#ifndef PARTICLE_SSE2
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PARTICLE_SSE2 1
+#else
+#define PARTICLE_SSE2 0
+#endif
+#endif
+
+#ifdef _MSC_VER
+#define ALIGN16 __declspec(align(16))
+#else
+#define ALIGN16 __attribute__((aligned(16)))
+#endif
+
+// AI Opponents (Survival mode)
+#define MAX_AI_SNAKES     32
+#define AI_SNAKE_COUNT    16     // Agents actually spawned
+#define MAX_AI_SNAKE_LEN  1024   // Per-agent body cap, power of two
+#define AI_FLOOD_LIMIT    192    // Max cells expanded per reachability probe
+// Shared planning budget per tick, in flood-fill cell expansions. Counted
+// work, not wall-clock time: replays of survival runs must make the same
+// search/skip decisions however loaded the recording machine was.
+#define AI_TICK_FLOOD_BUDGET (AI_FLOOD_LIMIT * 10)
+#define AI_RESPAWN_TICKS  100
+// Transient memory arenas (bump allocators). The frame arena resets at
+// the top of every Engine_RunFrame, the level arena on every Game_Reset;
+// sizes cover the worst-case sum of their documented consumers.
+#define FRAME_ARENA_SIZE (256 * 1024)
+#define LEVEL_ARENA_SIZE (ARENA_CELLS * sizeof(int) + 64 * 1024) // AI scratch + headroom, any board size
+
+// VT backend emission buffer: worst case is an SGR code plus a 3-byte
+// UTF-8 glyph per cell, so this leaves generous headroom.
+#define VT_BUF_SIZE      (256 * 1024)
+
+#define MAX_SCORES       10           // Rows shown on the leaderboard scene
 #define SAVE_FILE        "snake_engine.dat"
+#define SAVE_MAGIC       0x534E4B53   // "SNKS"
+#define SAVE_VERSION     2
+#define SAVE_MAX_ENTRIES 4096         // Compaction cap on stored run entries
+
+// Profiling
+#define PROFILE_HISTORY  32      // Frames shown in the F3 sparkline
+#define TRACE_CAPACITY   10240   // Frame records kept for the F4 binary dump
+#define TRACE_FILE       "snake_trace.bin"
+
+// Replay
+#define REPLAY_MAX_EVENTS 65536
+#define REPLAY_FILE       "snake_replay.rpl"
+#define REPLAY_MAGIC      0x534E4B52  // 'SNKR'
+#define REPLAY_VERSION    1
+
+// Netplay (lockstep versus over UDP). Both cabinets simulate both snakes
+// from the shared seed; only tick-stamped direction changes cross the wire.
+#define NET_PORT          42750
+#define NET_MAGIC         0x534E4B4E  // 'SNKN'
+#define NET_WINDOW        8      // Redundant trailing events per packet (loss cover)
+#define NET_LOG_SIZE      1024   // Per-side event history ring, power of two
+#define NET_INPUT_DELAY   1      // Ticks between a key press and its execution
+#define NET_HANDSHAKE_MS  15000  // How long --host / --join wait for a peer
+
+// Spectator broadcast (--cast emits, --view receives). The feed reuses
+// the diffing renderer's dirty spans, so steady-state frames are tiny.
+#define CAST_PORT         42751  // TCP; one viewer (the projector machine)
+#define CAST_MAGIC        0x534E4B43  // 'SNKC'
+#define CAST_BUF_SIZE     (64 * 1024) // Covers a worst-case RLE keyframe
+#define CAST_SEND_TIMEOUT 200    // ms before a wedged viewer is dropped
+#define CAST_RECV_POLL_MS 100    // Viewer wakes this often on an idle feed to poll keys
 
 // Colors (Foreground | Background)
 #define COL_BLACK       0
@@ -67,6 +197,13 @@ typedef struct {
     int y;
 } Vec2;
 
+// One PRNG stream (splitmix64 core). Unlocked, seedable, full 32-bit
+// output — replaces C rand(), whose MSVC build takes a lock and only
+// yields 15 bits (not even enough to index a large arena's cells).
+typedef struct {
+    unsigned long long state;
+} Rng;
+
 // Enumeration for Game Scenes
 typedef enum {
     SCENE_MENU,         // Main Menu
@@ -78,7 +215,10 @@ typedef enum {
 // Enumeration for Level Generation Modes
 typedef enum {
     MODE_CLASSIC,       // Open arena
-    MODE_OBSTACLES      // Procedurally generated walls
+    MODE_OBSTACLES,     // Procedurally generated walls
+    MODE_SURVIVAL,      // Open arena shared with AI snakes
+    MODE_SPEEDRUN,      // Classic rules plus tick-accurate timer and splits
+    MODE_VERSUS         // Lockstep head-to-head over UDP (--host / --join)
 } GameMode;
 
 // Persistent High Score Entry
@@ -88,24 +228,100 @@ typedef struct {
     int max_combo;
 } ScoreEntry;
 
-// Visual Particle for explosions/effects
+// On-disk save layout: header, then entry_count compacted ScoreEntry
+// records, then any number of journal records appended since the last
+// compaction. entry_size pins the struct layout so a rebuilt binary
+// refuses to misread an old file instead of silently corrupting it.
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int entry_size;   // sizeof(ScoreEntry) at write time
+    unsigned int entry_count;  // Records in the compacted region
+} SaveHeader;
+
+// Bump allocator over one backing block. Alloc is a pointer bump, free
+// is resetting the cursor, so subsystems drawing from an arena cost the
+// heap nothing in steady state.
+typedef struct {
+    unsigned char* base;
+    size_t cap;
+    size_t used;
+    size_t high_water;  // Peak usage, for sizing diagnostics
+    size_t fail_count;  // Allocations refused — the stress gate asserts zero
+} Arena;
+
+// In-memory leaderboard index: every journaled entry, kept sorted
+// descending by score. Ranked queries (top-k, rank of a score) are a
+// binary search, and a player's best is the first name match in order.
+// Built once at load, updated incrementally per Score_Add.
+typedef struct {
+    ScoreEntry* entries;
+    int count;
+    int cap;
+    int version;    // Bumped on every change; HUD caches key off it
+} ScoreIndex;
+
+// Open save file state. Game-over writes post one journal record to an
+// SPSC ring; a writer thread owns all file I/O so a slow disk (network
+// profile drives) can never stall the frame. The journal folds back
+// into the compacted region on shutdown.
+#define SAVE_QUEUE_SIZE 16
+typedef struct {
+    HANDLE hFile;
+    unsigned int base_count;      // Compacted records on disk
+    unsigned int journal_count;   // Appended since last compaction (writer thread)
+    ScoreEntry queue[SAVE_QUEUE_SIZE];
+    volatile LONG q_head;         // Consumer index (writer thread only)
+    volatile LONG q_tail;         // Producer index (main thread only)
+    HANDLE hWorkEvent;            // Wakes the writer on post and on quit
+    HANDLE hThread;
+    volatile LONG quit;           // Writer drains, then exits
+} SaveFile;
+
+// Visual Particles for explosions/effects.
+// Structure-of-arrays layout: slots [0, live_count) are alive, kept dense
+// by swap-with-last removal, so update/draw cost scales with the live
+// count rather than the cap and spawning is an O(1) append.
+// Positions and velocities are floats in cell units: motion integrates
+// at sub-cell precision (gravity + drag) and only quantizes to a cell
+// at draw time. The four arrays feeding the integration kernel are
+// 16-byte aligned for the SSE2 path.
 typedef struct {
-    Vec2 pos;
-    Vec2 vel;
-    int life;           // Ticks remaining
-    char icon;          // Character to render
-    WORD color;         // Color attribute
-} Particle;
-
-// The Player Entity
+    ALIGN16 float pos_x[MAX_PARTICLES];
+    ALIGN16 float pos_y[MAX_PARTICLES];
+    ALIGN16 float vel_x[MAX_PARTICLES];
+    ALIGN16 float vel_y[MAX_PARTICLES];
+    float prev_x[MAX_PARTICLES];    // Position at the previous tick, for blending
+    float prev_y[MAX_PARTICLES];
+    short life[MAX_PARTICLES];      // Ticks remaining
+    char icon[MAX_PARTICLES];       // Character to render
+    WORD color[MAX_PARTICLES];      // Color attribute
+    int live_count;
+} ParticleSystem;
+
+// A Snake Entity (player or AI)
+// Body is a ring buffer: segment i (0 = head) lives at body[(head + i) & cap_mask],
+// so a move is one head write instead of an O(length) shift. Bodies are
+// allocated once at startup; the player gets MAX_SNAKE_LEN slots, AI
+// agents MAX_AI_SNAKE_LEN.
 typedef struct {
-    Vec2 body[MAX_SNAKE_LEN];
+    Vec2* body;
+    int cap_mask;       // Capacity - 1; capacity is a power of two
+    int head;           // Ring index of the head segment
     int length;
     Vec2 dir;           // Current movement vector
     int grow_pending;   // How many segments to add
     WORD color_theme;   // Current dynamic color
 } Snake;
 
+// One AI-driven opponent (survival mode)
+typedef struct {
+    Snake snake;
+    bool alive;
+    int respawn_timer;  // Ticks until respawn after dying
+    Vec2 planned_dir;   // Refreshed under the shared budget; reused otherwise
+} AiAgent;
+
 // Circular Buffer for Input (prevents missed keys on fast turns)
 typedef struct {
     Vec2 queue[INPUT_QUEUE_SIZE];
@@ -114,6 +330,128 @@ typedef struct {
     int count;
 } InputBuffer;
 
+// Replay event codes
+enum {
+    REPLAY_EV_UP = 0, REPLAY_EV_DOWN, REPLAY_EV_LEFT, REPLAY_EV_RIGHT,
+    REPLAY_EV_DASH_ON, REPLAY_EV_DASH_OFF,
+    REPLAY_EV_PAD       // Tick-delta overflow chaining, no effect
+};
+
+// One recorded input change: three bytes per direction/dash flip, nothing
+// stored for ticks where the player does nothing
+typedef struct {
+    unsigned short tick_delta;  // Ticks since the previous event
+    unsigned char code;
+} ReplayEvent;
+
+// Deterministic session record: the RNG seed plus tick-stamped input
+// deltas are enough to re-simulate a whole run headlessly.
+typedef struct {
+    unsigned int seed;
+    unsigned char mode;         // GameMode of the run
+    bool recording;
+    bool playing;               // Suppresses re-recording during playback
+    int count;
+    unsigned int last_event_tick;
+    ReplayEvent events[REPLAY_MAX_EVENTS];
+} Replay;
+
+// Netplay packet types
+enum { NET_PKT_HELLO = 0, NET_PKT_START, NET_PKT_INPUT, NET_PKT_BYE };
+
+// One tick-stamped direction change — the whole unit of netplay traffic.
+// Codes reuse the replay event space so both systems share one encoding.
+typedef struct {
+    unsigned int tick;      // Absolute tick the change executes on
+    unsigned char code;     // REPLAY_EV_UP..REPLAY_EV_RIGHT
+} NetEvent;
+
+// Fixed-size datagram. INPUT packets carry the sender's trailing NET_WINDOW
+// events every frame; the receiver dedupes by sequence number, so a packet
+// loss is healed by any later arrival inside the window.
+typedef struct {
+    unsigned int magic;
+    unsigned char type;
+    unsigned char count;    // Events carried (INPUT)
+    unsigned short _pad;
+    unsigned int seed;      // Shared run seed (START)
+    unsigned int tick;      // Sender's next unsimulated tick — lockstep gate
+    unsigned int first_seq; // Log index of ev[0] (INPUT)
+    unsigned int ack;       // Peer events received gap-free so far (INPUT)
+    NetEvent ev[NET_WINDOW];
+} NetPacket;
+
+// Spectator feed message types
+enum { CAST_MSG_KEY = 0, CAST_MSG_DELTA };
+
+// Framing header for one spectator message; `size` bytes of payload follow
+typedef struct {
+    unsigned int magic;
+    unsigned short type;    // CAST_MSG_*
+    unsigned short count;   // RLE runs (KEY) or dirty spans (DELTA)
+    unsigned int size;      // Payload length in bytes
+} CastHeader;
+
+// One cell on the wire — CHAR_INFO minus the union padding concerns
+typedef struct {
+    unsigned short ch;      // UTF-16 code unit
+    unsigned short attr;    // Win32 attribute word
+} CastCell;
+
+// Broadcaster state, owned by the render thread once listening
+typedef struct {
+    bool listening;
+    SOCKET listen_sock;
+    SOCKET client;
+    bool client_valid;
+    bool key_pending;       // Next publish must be a full keyframe
+    CHAR_INFO* shadow;      // What the viewer currently shows
+    char* buf;              // Message assembly area
+} Caster;
+
+// Lockstep session state. Each side keeps an append-only log of its own
+// events plus a gap-free mirror of the peer's; both machines execute both
+// logs at the stamped ticks, host snake always first.
+typedef struct {
+    bool active;
+    bool host;                 // Host's snake simulates first each tick
+    bool local_won;            // Set when the peer's snake dies (or it leaves)
+    SOCKET sock;
+    struct sockaddr_in peer;
+    NetEvent local_log[NET_LOG_SIZE];
+    int local_count;
+    int local_applied;         // First local event not yet executed
+    NetEvent remote_log[NET_LOG_SIZE];
+    int remote_count;
+    int remote_applied;
+    unsigned int remote_tick;  // Peer's reported next tick
+    unsigned int local_acked;  // Own events the peer confirmed; resends start here
+} Net;
+
+// One 32x32 tile of the wall layer; rows are contiguous so scanning a
+// chunk (baking, rebuilds) walks memory linearly
+typedef struct {
+    unsigned char cells[CHUNK_SIZE][CHUNK_SIZE]; // [row][col]
+} MapChunk;
+
+// A single key transition captured by the input thread
+typedef struct {
+    WORD vk;
+    bool down;
+} KeyEvent;
+
+// Input thread state: ReadConsoleInput events flow through a lock-free
+// SPSC ring (input thread produces, main thread consumes). The held-state
+// table gives Sleep-free edge detection on the consumer side.
+typedef struct {
+    HANDLE hInput;
+    HANDLE hThread;
+    KeyEvent events[KEY_EVENT_QUEUE_SIZE];
+    volatile LONG ev_head;  // Consumer index (main thread only)
+    volatile LONG ev_tail;  // Producer index (input thread only)
+    bool key_down[256];     // Live held state, updated on the main thread
+} InputSystem;
+
 // Main Game State Container
 typedef struct {
     // Systems
@@ -127,6 +465,17 @@ typedef struct {
     GameMode mode;
     Snake snake;
     Vec2 food;
+
+    // AI Opponents (survival mode)
+    AiAgent ai[MAX_AI_SNAKES];
+    int ai_count;
+    int ai_cursor;      // Round-robin start index so budget shortfalls rotate
+
+    // RNG streams, reseeded per run (replay restores the same seeds).
+    // Separate streams mean cosmetic draws can't perturb the sim stream.
+    Rng rng_world;      // Level layout + food placement
+    Rng rng_fx;         // Particle visuals
+    Rng rng_ai;         // AI decisions
     
     // Stats
     int score;
@@ -135,25 +484,117 @@ typedef struct {
     bool is_dashing;    // True if Shift is held
     bool has_started;   // False until first input
 
-    // World
-    unsigned char map[SCREEN_WIDTH][SCREEN_HEIGHT]; // 1 = Wall, 0 = Empty
-    Particle particles[MAX_PARTICLES];
+    // World — wall layer stored as row-major 32x32 chunks (1 = Wall, 0 = Empty)
+    MapChunk chunks[ARENA_CHUNKS_Y][ARENA_CHUNKS_X];
+    Vec2 camera;        // Top-left arena cell of the visible window
+    ParticleSystem particles;
+
+    // Occupancy grid: walls + snake body, one bit per cell.
+    // Collision is a single bit test; the free-cell list makes food
+    // placement a single random pick instead of rejection sampling.
+    unsigned int occupancy[(ARENA_CELLS + 31) / 32];
+    int free_cells[ARENA_CELLS]; // Cell ids currently unoccupied
+    int free_index[ARENA_CELLS]; // Cell id -> slot in free_cells, -1 if occupied
+    int free_count;
     
     // UI/Meta
     char player_name[16];
     int name_cursor;
     
     // Timing
+    unsigned int tick_count; // Fixed ticks executed since Game_Reset
+    // Speedrun accounting: simulated time as the sum of executed tick
+    // intervals in whole microseconds, so results are identical no
+    // matter how fast or slow rendering runs
+    unsigned long long run_time_us;
+    unsigned long long split_us[SPEEDRUN_SPLITS]; // Stamped at each milestone
+    int splits_taken;
     double time_accumulator;
+    double tick_interval;    // Length of the most recent fixed tick (dash-adjusted)
+    bool interp_valid;       // Last tick advanced the sim, so blending is meaningful
     double fps;
 } GameState;
 
+// One frame's phase timings, as written to the binary trace file
+typedef struct {
+    float frame_ms;     // Whole-frame delta time
+    float input_ms;     // Input_Process
+    float update_ms;    // Fixed-step logic (all ticks this frame)
+    float draw_ms;      // Game_Draw + Render_Submit
+    float present_ms;   // Last Render_Present on the render thread
+} FrameRecord;
+
+// Frame-time instrumentation behind the F3 overlay. The trace is a ring
+// of the last TRACE_CAPACITY frames, dumped to TRACE_FILE on F4.
+typedef struct {
+    double input_ms, update_ms, draw_ms;    // Last frame, main thread
+    volatile LONG present_us;               // Published by the render thread
+    float history[PROFILE_HISTORY];         // Rolling frame totals for the sparkline
+    int history_head;
+    FrameRecord trace[TRACE_CAPACITY];
+    int trace_head;
+    int trace_count;
+} Profiler;
+
+// Frame pacing: waitable high-res timer for the coarse wait, then a short
+// spin so the frame boundary lands consistently despite Sleep granularity.
+typedef struct {
+    HANDLE hTimer;
+    double frame_budget;            // Seconds per frame
+    LARGE_INTEGER next_deadline;    // QPC time the current frame should end at
+} FramePacer;
+
+// One cached HUD line: text is formatted and pre-rendered to CHAR_INFO
+// only when the source values in key[] change; every other frame the
+// draw path memcpy-blits the cached run. Avoids per-frame sprintf.
+typedef struct {
+    CHAR_INFO cells[SCREEN_WIDTH];
+    int len;
+    int key[4];     // Source values the line was last built from
+    bool valid;
+} HudLine;
+
+typedef struct {
+    HudLine status;             // Score / combo / dash bar
+    HudLine gameover;           // Final score + rank
+    HudLine board[MAX_SCORES];  // Leaderboard rows
+    HudLine board_best;         // Player's best + rank footer
+    HudLine dbg_fps;
+    HudLine dbg_phase;          // Per-phase frame timings
+    HudLine dbg_trace;
+    HudLine sr_timer;           // Speedrun clock
+    HudLine sr_split[SPEEDRUN_SPLITS];
+    HudLine sr_final;           // Final time on the death screen
+} HudCache;
+
 // Low-Level Renderer State
+// Presentation runs on its own thread. Three frame buffers rotate through
+// a single-slot atomic mailbox: the main thread draws into pixel_data and
+// swaps it into the mailbox, the render thread swaps its displayed frame
+// out for whatever is freshest. Handoff is a pointer exchange, no copying.
 typedef struct {
     HANDLE hConsole;
     HANDLE hBuffer[2];      // Front and Back buffers
     int back_buffer_index;  // 0 or 1
-    CHAR_INFO* pixel_data;  // Raw pixel array
+    CHAR_INFO* frames[3];   // Triple-buffered frame storage
+    CHAR_INFO* pixel_data;  // Main thread's current draw target (one of frames[])
+    CHAR_INFO* volatile mailbox;    // Handoff slot between the two threads
+    CHAR_INFO* display_frame;       // Render thread's current frame
+    volatile LONG frame_ready;      // Set when the mailbox holds an unconsumed frame
+    HANDLE hFrameEvent;     // Wakes the render thread on submit
+    HANDLE hRenderThread;
+    CHAR_INFO* shadow_data[2]; // Last frame written to each buffer (for diffing)
+    bool shadow_valid[2];   // False until a full frame has been pushed to that buffer
+    CHAR_INFO* background;  // Pre-rendered static map layer, baked per level
+    bool headless;          // Benchmark mode: no console attached, count bytes instead
+    unsigned long long bytes_written; // Console payload bytes (real or simulated)
+
+    // VT backend (--vt): frames are composed as ANSI escape sequences in
+    // vt_buf and flushed with one WriteFile, instead of buffer swapping
+    bool use_vt;
+    HANDLE hVtOut;          // Std output handle the VT stream writes to
+    char* vt_buf;           // Preallocated emission buffer
+    size_t vt_len;
 } Renderer;
 
 // ======================================================================================
@@ -162,7 +603,26 @@ typedef struct {
 
 Renderer r;
 GameState g;
-ScoreEntry leaderboard[MAX_SCORES];
+InputSystem in;
+Profiler prof;
+FramePacer pacer;
+Replay replay;
+Net net;
+Caster cast;
+
+// AI flood-fill scratch, shared by all agents (planning is sequential).
+// Generation-stamped visits avoid clearing the array between probes.
+// Lives in the level arena; Game_Reset reallocates and zeroes it.
+int* ai_visit;
+int ai_visit_gen;
+int* ai_queue;
+int ai_flood_spent; // Cells expanded by probes this tick, against AI_TICK_FLOOD_BUDGET
+ScoreIndex scores;
+SaveFile save;
+HudCache hud;
+static const int speedrun_milestones[SPEEDRUN_SPLITS] = { 100, 250, 500 };
+Arena arena_frame;  // Reset every Engine_RunFrame (or harness tick)
+Arena arena_level;  // Reset every Game_Reset
 LARGE_INTEGER perf_freq;
 
 // ======================================================================================
@@ -172,40 +632,162 @@ LARGE_INTEGER perf_freq;
 // Core Engine
 void Engine_Initialize();
 void Engine_Shutdown();
+void Arena_CreateAll();    // Back the frame/level arenas (any boot path)
+void* Arena_Alloc(Arena* a, size_t size); // Bump; NULL once exhausted
+void Arena_Reset(Arena* a);
 void Engine_RunFrame(double dt);
+void Pacing_WaitNextFrame(); // Block until the frame budget is spent
 
 // Rendering
 void Render_Clear(WORD color);
 void Render_Char(int x, int y, wchar_t ch, WORD attr);
 void Render_String(int x, int y, const char* str, WORD attr);
 void Render_Box(int x, int y, int w, int h, WORD attr);
-void Render_Present(); // Swap buffers
+void Render_Fill(int x, int y, int count, wchar_t ch, WORD attr); // Row-span fill
+void Render_FillCol(int x, int y, int count, wchar_t ch, WORD attr); // Column-span fill
+void Render_BlitRow(int x, int y, const CHAR_INFO* src, int count);
+void Render_BakeBackground();           // Precompose the static map into r.background
+void Render_Submit();                   // Publish the drawn frame to the render thread
+void Render_Present(CHAR_INFO* frame);  // Render thread only: push frame to console
+DWORD WINAPI Render_ThreadProc(LPVOID param);
 
 // Game Logic
 void Game_Reset();
 void Game_UpdateFixed(); // Physics/Logic tick
+void Snake_AllocBodies();             // One-time ring buffer allocation
+Vec2 Snake_SegmentOf(const Snake* s, int i);
+Vec2 Snake_Segment(int i); // i-th player body segment, 0 = head
+Vec2 Snake_PrevSegmentOf(const Snake* s, int i); // Segment i one tick ago
+float Game_InterpAlpha();  // Elapsed fraction of the current tick [0,1]
+wchar_t Interp_Glyph(float fx, float fy, int* cx, int* cy);
+
+// AI Opponents
+void AI_ResetAll();                   // Stage agents for survival mode
+void AI_UpdateAll();                  // One tick for every agent, budgeted planning
+Vec2 AI_PlanDir(AiAgent* a, bool allow_search);
+int AI_FloodCount(int x, int y, int limit);
 void Game_Draw();        // Drawing routine
 void Input_Process();
 void Input_Enqueue(Vec2 dir);
+void Input_HandleKey(WORD vk);  // One key-down edge, dispatched by scene
+DWORD WINAPI Input_ThreadProc(LPVOID param);
 
 // Systems
+void Rng_Seed(Rng* rng, unsigned long long seed);
+unsigned int Rng_Next(Rng* rng);                 // 32 random bits
+unsigned int Rng_Range(Rng* rng, unsigned int n); // Uniform in [0, n)
+void Rng_Fill(Rng* rng, unsigned int* out, int count); // Bulk draw
+unsigned char Map_Get(int x, int y);            // Wall layer, chunked storage
+void Map_Set(int x, int y, unsigned char v);
+void Grid_Occupy(int x, int y);
+void Grid_Free(int x, int y);
+bool Grid_IsBlocked(int x, int y);
+bool Grid_RandomFreeCell(Vec2* out);
+int  Level_Flood(int sx, int sy);      // Reachable cells from spawn -> free_cells
+void Level_Validate(int sx, int sy);   // Carve pockets open, publish free pool
 void Level_Generate(GameMode mode);
 void Particles_Spawn(int x, int y, int count, WORD color);
 void Particles_Update();
-void Score_Load();
-void Score_Save();
+void Score_Load();                     // Open + map SAVE_FILE, build index, start writer
+void Score_Save();                     // Wake the persistence writer (I/O is off-thread)
+void Score_Compact();                  // Shutdown: drain writer, fold journal into base
+DWORD WINAPI Score_WriterProc(LPVOID param); // Owns all save-file writes
 void Score_Add(const char* name, int score);
+int Score_RankOf(int score);           // 1-based rank a score would place at
+const ScoreEntry* Score_Top(int i);    // i-th best entry, or NULL past the end
+const ScoreEntry* Score_BestOf(const char* name);
+
+// Profiling
+void Profiler_Record(double frame_ms); // Push one frame into history + trace ring
+void Profiler_DumpTrace();             // Write the trace ring to TRACE_FILE
+
+// Replay
+void Replay_RecordEvent(unsigned char code);
+void Replay_Save();                    // Write the current recording to REPLAY_FILE
+void Replay_Play(const char* path);    // Headless max-speed re-simulation
+
+// Netplay (--host / --join)
+bool Net_Host();                       // Bind, wait for a peer, agree on the seed
+bool Net_Join(const char* ip);
+void Net_Pump();                       // Drain the socket, merge events, send ours
+bool Net_CanStep();                    // Lockstep gate for the fixed-tick loop
+void Net_QueueLocal(unsigned char code); // Stamp + log one local direction change
+void Net_ApplyEvents(NetEvent* log, int count, int* applied, Snake* s);
+void Net_StepRemote();                 // Simulate the peer snake for this tick
+void Net_Shutdown();
+
+// Spectator broadcast (--cast / --view)
+bool Cast_Start();                     // Listen for the projector's viewer
+void Cast_PublishFrame(CHAR_INFO* frame); // Render thread: diff, encode, send
+int  Cast_ViewerRun(const char* ip);   // Viewer process: feed -> Renderer
+void Cast_Shutdown();
+
+// Benchmark Harness (--bench)
+void Benchmark_Run(long long ticks);
+Vec2 Benchmark_BotDir();
+static void Bench_BootHeadless(); // Shared headless boot: --bench, --stress, --replay
+static void Bench_FreeHeadless();
+
+// Stress scenarios (--stress <name>): worst-case boards as a release gate
+int Stress_Run(const char* name, long long ticks);
 
 // ======================================================================================
 // MAIN ENTRY POINT
 // ======================================================================================
 
-int main() {
+int main(int argc, char* argv[]) {
+    // High Resolution Timer Setup
+    QueryPerformanceFrequency(&perf_freq);
+
+    // Backend flags first, so they take effect whatever order they share
+    // the command line with the mode flags below (e.g. --bench --vt)
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--vt") == 0) {
+            r.use_vt = true; // ANSI/VT backend (Windows Terminal, remote TTYs)
+        }
+    }
+
+    // Headless benchmark mode: no console, no threads, scripted bot
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0) {
+            long long ticks = 1000000;
+            if (i + 1 < argc) ticks = atoll(argv[i + 1]);
+            Benchmark_Run(ticks);
+            return 0;
+        }
+        if (strcmp(argv[i], "--stress") == 0 && i + 1 < argc) {
+            long long ticks = 20000;
+            if (i + 2 < argc) ticks = atoll(argv[i + 2]);
+            return Stress_Run(argv[i + 1], ticks); // Nonzero exit on regression
+        }
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            Replay_Play(argv[i + 1]);
+            return 0;
+        }
+        if (strcmp(argv[i], "--host") == 0) {
+            if (!Net_Host()) return 1; // Handshake failed / timed out
+        }
+        if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            if (!Net_Join(argv[i + 1])) return 1;
+        }
+        if (strcmp(argv[i], "--cast") == 0) {
+            if (!Cast_Start()) return 1;
+        }
+        if (strcmp(argv[i], "--view") == 0 && i + 1 < argc) {
+            return Cast_ViewerRun(argv[i + 1]); // Pure spectator process
+        }
+    }
+
     Engine_Initialize();
     Score_Load();
 
-    // High Resolution Timer Setup
-    QueryPerformanceFrequency(&perf_freq);
+    // A completed handshake drops both cabinets straight into the match
+    if (net.active) {
+        g.mode = MODE_VERSUS;
+        g.scene = SCENE_GAME;
+        Game_Reset();
+    }
+
     LARGE_INTEGER last_tick;
     QueryPerformanceCounter(&last_tick);
 
@@ -232,9 +814,9 @@ int main() {
         if (frame_time > 0.25) frame_time = 0.25;
 
         Engine_RunFrame(frame_time);
-        
-        // Yield CPU to prevent 100% usage on a simple game
-        Sleep(1); 
+
+        // Pace to the frame budget (coarse timer wait + sub-ms spin)
+        Pacing_WaitNextFrame();
     }
 
     Engine_Shutdown();
@@ -245,51 +827,161 @@ int main() {
 // ENGINE IMPLEMENTATION
 // ======================================================================================
 
+// --- Transient memory arenas ----------------------------------------------------------
+
+static void Arena_Create(Arena* a, size_t cap) {
+    if (a->base) return; // Already backed (several boot paths call this)
+    a->base = (unsigned char*)malloc(cap);
+    a->cap = cap;
+    a->used = 0;
+    a->high_water = 0;
+}
+
+void Arena_CreateAll() {
+    Arena_Create(&arena_frame, FRAME_ARENA_SIZE);
+    Arena_Create(&arena_level, LEVEL_ARENA_SIZE);
+}
+
+void* Arena_Alloc(Arena* a, size_t size) {
+    size = (size + 15) & ~(size_t)15; // 16-byte alignment for SIMD consumers
+    if (!a->base || a->used + size > a->cap) {
+        a->fail_count++;  // Callers degrade, not crash; the counter still tattles
+        return NULL;
+    }
+    void* p = a->base + a->used;
+    a->used += size;
+    if (a->used > a->high_water) a->high_water = a->used;
+    return p;
+}
+
+void Arena_Reset(Arena* a) {
+    a->used = 0;
+}
+
 void Engine_Initialize() {
     // 1. Setup Console
     r.hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
     SetConsoleTitleA(APP_TITLE);
 
-    // 2. Setup Screen Buffers (Double Buffering)
-    COORD buffer_size = { SCREEN_WIDTH, SCREEN_HEIGHT };
-    SMALL_RECT window_rect = { 0, 0, (SHORT)(SCREEN_WIDTH - 1), (SHORT)(SCREEN_HEIGHT - 1) };
-
-    for(int i=0; i<2; i++) {
-        r.hBuffer[i] = CreateConsoleScreenBuffer(
-            GENERIC_READ | GENERIC_WRITE,
-            FILE_SHARE_READ | FILE_SHARE_WRITE,
-            NULL,
-            CONSOLE_TEXTMODE_BUFFER,
-            NULL
-        );
-        SetConsoleScreenBufferSize(r.hBuffer[i], buffer_size);
-        SetConsoleWindowInfo(r.hBuffer[i], TRUE, &window_rect);
-        
-        // Hide Cursor
-        CONSOLE_CURSOR_INFO cursor = { 1, FALSE };
-        SetConsoleCursorInfo(r.hBuffer[i], &cursor);
+    // 2. Setup the presentation backend
+    if (r.use_vt) {
+        // VT stream: enable escape processing, switch to the alternate
+        // screen and hide the cursor via the stream itself
+        r.hVtOut = r.hConsole;
+        DWORD mode = 0;
+        GetConsoleMode(r.hVtOut, &mode);
+        SetConsoleMode(r.hVtOut, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+        r.vt_buf = (char*)malloc(VT_BUF_SIZE);
+
+        DWORD written;
+        const char* boot = "\x1b[?1049h\x1b[?25l";
+        WriteFile(r.hVtOut, boot, (DWORD)strlen(boot), &written, NULL);
+    } else {
+        // Legacy Win32 double buffering
+        COORD buffer_size = { SCREEN_WIDTH, SCREEN_HEIGHT };
+        SMALL_RECT window_rect = { 0, 0, (SHORT)(SCREEN_WIDTH - 1), (SHORT)(SCREEN_HEIGHT - 1) };
+
+        for(int i=0; i<2; i++) {
+            r.hBuffer[i] = CreateConsoleScreenBuffer(
+                GENERIC_READ | GENERIC_WRITE,
+                FILE_SHARE_READ | FILE_SHARE_WRITE,
+                NULL,
+                CONSOLE_TEXTMODE_BUFFER,
+                NULL
+            );
+            SetConsoleScreenBufferSize(r.hBuffer[i], buffer_size);
+            SetConsoleWindowInfo(r.hBuffer[i], TRUE, &window_rect);
+
+            // Hide Cursor
+            CONSOLE_CURSOR_INFO cursor = { 1, FALSE };
+            SetConsoleCursorInfo(r.hBuffer[i], &cursor);
+        }
     }
 
     // 3. Allocate Memory
-    r.pixel_data = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    for(int i=0; i<3; i++) {
+        r.frames[i] = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        memset(r.frames[i], 0, sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+    r.pixel_data = r.frames[0];     // Main thread draws here
+    r.mailbox = r.frames[1];        // In-flight slot
+    r.display_frame = r.frames[2];  // Render thread owns this one
+    r.frame_ready = 0;
+    r.background = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * ARENA_CELLS);
+    for(int i=0; i<2; i++) {
+        r.shadow_data[i] = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        r.shadow_valid[i] = false;
+    }
     r.back_buffer_index = 0;
 
     // 4. Initialize State
     g.is_running = true;
     g.scene = SCENE_MENU;
-    srand((unsigned int)time(NULL));
+    Arena_CreateAll();
+    Snake_AllocBodies();
+
+    // 5. Start Input Thread
+    in.hInput = GetStdHandle(STD_INPUT_HANDLE);
+    SetConsoleMode(in.hInput, ENABLE_WINDOW_INPUT | ENABLE_EXTENDED_FLAGS);
+    in.ev_head = in.ev_tail = 0;
+    in.hThread = CreateThread(NULL, 0, Input_ThreadProc, NULL, 0, NULL);
+
+    // 6. Start Render Thread
+    r.hFrameEvent = CreateEventA(NULL, FALSE, FALSE, NULL); // Auto-reset
+    r.hRenderThread = CreateThread(NULL, 0, Render_ThreadProc, NULL, 0, NULL);
+
+    // 7. Frame Pacing (1ms scheduler granularity for the whole process)
+    timeBeginPeriod(1);
+    pacer.hTimer = CreateWaitableTimerA(NULL, TRUE, NULL); // Manual-reset
+    pacer.frame_budget = 1.0 / FRAME_RATE_CAP;
+    pacer.next_deadline.QuadPart = 0;
 }
 
 void Engine_Shutdown() {
-    free(r.pixel_data);
-    CloseHandle(r.hBuffer[0]);
-    CloseHandle(r.hBuffer[1]);
+    Net_Shutdown();  // Tell a live peer we are gone before anything blocks
+    Score_Compact(); // Fold the score journal before handles go away
+    timeEndPeriod(1);
+    CloseHandle(pacer.hTimer);
+
+    // Wake the render thread so it can observe is_running == false and exit
+    SetEvent(r.hFrameEvent);
+    WaitForSingleObject(r.hRenderThread, 1000);
+    CloseHandle(r.hRenderThread);
+    CloseHandle(r.hFrameEvent);
+    Cast_Shutdown(); // After the join: the render thread owned the feed
+
+    // The input thread is likely blocked in ReadConsoleInput; it checks
+    // g.is_running on wake and dies with the process either way.
+    CloseHandle(in.hThread);
+
+    for(int i=0; i<3; i++) free(r.frames[i]);
+    free(r.background);
+    free(r.shadow_data[0]);
+    free(r.shadow_data[1]);
+    free(arena_frame.base);
+    free(arena_level.base);
+    if (r.use_vt) {
+        // Leave the alternate screen and restore the cursor
+        DWORD written;
+        const char* bye = "\x1b[0m\x1b[?25h\x1b[?1049l";
+        WriteFile(r.hVtOut, bye, (DWORD)strlen(bye), &written, NULL);
+        free(r.vt_buf);
+    } else {
+        CloseHandle(r.hBuffer[0]);
+        CloseHandle(r.hBuffer[1]);
+    }
 }
 
 void Engine_RunFrame(double dt) {
+    LARGE_INTEGER t0, t1, t2, t3;
     g.time_accumulator += dt;
 
+    // Everything bump-allocated last frame is dead now
+    Arena_Reset(&arena_frame);
+
+    QueryPerformanceCounter(&t0);
     Input_Process();
+    QueryPerformanceCounter(&t1);
 
     // Fixed Time Step Update
     // Logic runs at a constant rate, regardless of FPS
@@ -298,22 +990,78 @@ void Engine_RunFrame(double dt) {
     if (g.is_dashing && g.scene == SCENE_GAME) {
         current_tick_rate /= DASH_MULTIPLIER;
     }
+    g.tick_interval = current_tick_rate;
+
+    // Versus: exchange packets every frame (even while stalled, so the
+    // peer keeps receiving our confirmed-tick watermark)
+    if (net.active && g.scene == SCENE_GAME) Net_Pump();
 
     while (g.time_accumulator >= current_tick_rate) {
-        if (g.scene == SCENE_GAME && g.has_started && !g.is_paused) {
+        // Lockstep gate: never simulate a tick the peer has not covered.
+        // Cap the accumulator so a stall doesn't bank a burst of ticks.
+        if (net.active && g.scene == SCENE_GAME && !Net_CanStep()) {
+            if (g.time_accumulator > current_tick_rate) g.time_accumulator = current_tick_rate;
+            break;
+        }
+
+        // Presentation blending only makes sense off the back of a tick
+        // that actually moved things; paused/menu ticks pin alpha to 1
+        g.interp_valid = (g.scene == SCENE_GAME && g.has_started && !g.is_paused);
+        if (g.interp_valid) {
             Game_UpdateFixed();
         }
-        
+
         // Particles update in all scenes if we wanted, but let's keep them in game
         if (g.scene == SCENE_GAME) {
             Particles_Update();
         }
-        
+
         g.time_accumulator -= current_tick_rate;
     }
+    QueryPerformanceCounter(&t2);
 
     Game_Draw();
-    Render_Present();
+    Render_Submit();
+    QueryPerformanceCounter(&t3);
+
+    prof.input_ms  = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / perf_freq.QuadPart;
+    prof.update_ms = (double)(t2.QuadPart - t1.QuadPart) * 1000.0 / perf_freq.QuadPart;
+    prof.draw_ms   = (double)(t3.QuadPart - t2.QuadPart) * 1000.0 / perf_freq.QuadPart;
+    Profiler_Record(dt * 1000.0);
+}
+
+void Pacing_WaitNextFrame() {
+    LONGLONG budget_qpc = (LONGLONG)(pacer.frame_budget * perf_freq.QuadPart);
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+
+    if (pacer.next_deadline.QuadPart == 0) {
+        pacer.next_deadline.QuadPart = now.QuadPart + budget_qpc;
+    }
+
+    LONGLONG remaining = pacer.next_deadline.QuadPart - now.QuadPart;
+    if (remaining > 0) {
+        // Coarse wait on the high-res timer, leaving ~1ms of slack
+        double remaining_ms = (double)remaining * 1000.0 / perf_freq.QuadPart;
+        if (remaining_ms > 1.5) {
+            LARGE_INTEGER due;
+            due.QuadPart = -(LONGLONG)((remaining_ms - 1.0) * 10000.0); // Relative, 100ns units
+            SetWaitableTimer(pacer.hTimer, &due, 0, NULL, NULL, FALSE);
+            WaitForSingleObject(pacer.hTimer, INFINITE);
+        }
+
+        // Spin out the final sub-millisecond so the boundary lands consistently
+        do {
+            YieldProcessor();
+            QueryPerformanceCounter(&now);
+        } while (now.QuadPart < pacer.next_deadline.QuadPart);
+    }
+
+    // Advance; if we fell more than a frame behind, resync rather than rush
+    pacer.next_deadline.QuadPart += budget_qpc;
+    if (now.QuadPart > pacer.next_deadline.QuadPart) {
+        pacer.next_deadline.QuadPart = now.QuadPart + budget_qpc;
+    }
 }
 
 // ======================================================================================
@@ -329,7 +1077,7 @@ void Render_Clear(WORD color) {
 
 void Render_Char(int x, int y, wchar_t ch, WORD attr) {
     if (x < 0 || x >= SCREEN_WIDTH || y < 0 || y >= SCREEN_HEIGHT) return;
-    int idx = y * SCREEN_WIDTH + x;
+    int idx = Screen_Index(x, y);
     r.pixel_data[idx].Char.UnicodeChar = ch;
     r.pixel_data[idx].Attributes = attr;
 }
@@ -340,6 +1088,151 @@ void Render_String(int x, int y, const char* str, WORD attr) {
     }
 }
 
+// Row-span fill of one precomposed cell value — one bounds check and one
+// index computation for the whole run instead of per cell
+void Render_Fill(int x, int y, int count, wchar_t ch, WORD attr) {
+    if (y < 0 || y >= SCREEN_HEIGHT) return;
+    if (x < 0) { count += x; x = 0; }
+    if (x + count > SCREEN_WIDTH) count = SCREEN_WIDTH - x;
+    if (count <= 0) return;
+
+    CHAR_INFO cell;
+    cell.Char.UnicodeChar = ch;
+    cell.Attributes = attr;
+
+    CHAR_INFO* row = r.pixel_data + Screen_Index(x, y);
+    for (int i = 0; i < count; i++) row[i] = cell;
+}
+
+// Column-span variant for vertical runs: one clip, strided stores
+void Render_FillCol(int x, int y, int count, wchar_t ch, WORD attr) {
+    if (x < 0 || x >= SCREEN_WIDTH) return;
+    if (y < 0) { count += y; y = 0; }
+    if (y + count > SCREEN_HEIGHT) count = SCREEN_HEIGHT - y;
+    if (count <= 0) return;
+
+    CHAR_INFO cell;
+    cell.Char.UnicodeChar = ch;
+    cell.Attributes = attr;
+
+    CHAR_INFO* p = r.pixel_data + Screen_Index(x, y);
+    for (int i = 0; i < count; i++, p += SCREEN_WIDTH) *p = cell;
+}
+
+// Copy a run of already-composed cells into the frame
+void Render_BlitRow(int x, int y, const CHAR_INFO* src, int count) {
+    if (y < 0 || y >= SCREEN_HEIGHT) return;
+    if (x < 0) { src -= x; count += x; x = 0; }
+    if (x + count > SCREEN_WIDTH) count = SCREEN_WIDTH - x;
+    if (count <= 0) return;
+    memcpy(r.pixel_data + Screen_Index(x, y), src, sizeof(CHAR_INFO) * count);
+}
+
+// --- Cached HUD text ------------------------------------------------------------------
+// Tiny formatting kernel (chars written as return value) — no CRT
+// formatted I/O anywhere on the frame path.
+
+static int Fmt_Str(char* out, const char* s) {
+    int n = 0;
+    while (s[n]) { out[n] = s[n]; n++; }
+    return n;
+}
+
+static int Fmt_Int(char* out, int v) {
+    char tmp[12];
+    int n = 0, t = 0;
+    unsigned int u = (v < 0) ? (out[n++] = '-', (unsigned int)(-(long long)v)) : (unsigned int)v;
+    do { tmp[t++] = (char)('0' + u % 10); u /= 10; } while (u);
+    while (t) out[n++] = tmp[--t];
+    return n;
+}
+
+// Right-align within `width` (space-padded); overlong values just run over
+static int Fmt_IntPad(char* out, int v, int width) {
+    char tmp[12];
+    int len = Fmt_Int(tmp, v);
+    int n = 0;
+    for (; n < width - len; n++) out[n] = ' ';
+    memcpy(out + n, tmp, len);
+    return (n + len > width) ? n + len : width;
+}
+
+// Left-align within `width`, space-padded, truncating if necessary
+static int Fmt_StrPad(char* out, const char* s, int width) {
+    int n = 0;
+    while (s[n] && n < width) { out[n] = s[n]; n++; }
+    while (n < width) out[n++] = ' ';
+    return n;
+}
+
+// M:SS.mmm from microseconds (speedrun clock and splits)
+static int Fmt_TimeUs(char* out, unsigned long long us) {
+    unsigned long long ms = us / 1000;
+    int n = Fmt_Int(out, (int)(ms / 60000));
+    out[n++] = ':';
+    int sec = (int)((ms / 1000) % 60);
+    out[n++] = (char)('0' + sec / 10);
+    out[n++] = (char)('0' + sec % 10);
+    out[n++] = '.';
+    int mil = (int)(ms % 1000);
+    out[n++] = (char)('0' + mil / 100);
+    out[n++] = (char)('0' + (mil / 10) % 10);
+    out[n++] = (char)('0' + mil % 10);
+    return n;
+}
+
+// Fixed-point with two decimals, integer part right-aligned in width-3
+static int Fmt_Fixed2(char* out, double v, int width) {
+    if (v < 0) v = 0;
+    int centi = (int)(v * 100.0 + 0.5);
+    int n = Fmt_IntPad(out, centi / 100, width - 3);
+    out[n++] = '.';
+    out[n++] = (char)('0' + (centi / 10) % 10);
+    out[n++] = (char)('0' + centi % 10);
+    return n;
+}
+
+// True when the cached line is stale for these source values; the
+// caller then reformats and commits, otherwise the old cells stand
+static bool Hud_Begin(HudLine* line, int k0, int k1, int k2, int k3) {
+    if (line->valid && line->key[0] == k0 && line->key[1] == k1 &&
+        line->key[2] == k2 && line->key[3] == k3) return false;
+    line->key[0] = k0; line->key[1] = k1; line->key[2] = k2; line->key[3] = k3;
+    line->valid = true;
+    return true;
+}
+
+static void Hud_Commit(HudLine* line, const char* text, WORD attr) {
+    int n = 0;
+    while (text[n] && n < SCREEN_WIDTH) {
+        line->cells[n].Char.UnicodeChar = (wchar_t)text[n];
+        line->cells[n].Attributes = attr;
+        n++;
+    }
+    line->len = n;
+}
+
+static void Hud_Blit(const HudLine* line, int x, int y) {
+    Render_BlitRow(x, y, line->cells, line->len);
+}
+
+// Compose the whole arena's static map once per level; Game_Draw extracts
+// the camera window from it with one contiguous copy per visible row
+void Render_BakeBackground() {
+    for (int y = 0; y < ARENA_HEIGHT; y++) {
+        for (int x = 0; x < ARENA_WIDTH; x++) {
+            CHAR_INFO* cell = &r.background[Arena_Index(x, y)];
+            if (Map_Get(x, y)) {
+                cell->Char.UnicodeChar = 0x2588;
+                cell->Attributes = COL_GRAY;
+            } else {
+                cell->Char.UnicodeChar = L' ';
+                cell->Attributes = COL_BLACK;
+            }
+        }
+    }
+}
+
 void Render_Box(int x, int y, int w, int h, WORD attr) {
     // Unicode Box Drawing
     Render_Char(x, y, 0x2554, attr);            // ╔
@@ -357,21 +1250,172 @@ void Render_Box(int x, int y, int w, int h, WORD attr) {
     }
 }
 
-void Render_Present() {
+// Called from the main thread once a frame is fully drawn: swap the drawn
+// frame into the mailbox and take whatever was there as the next draw target.
+void Render_Submit() {
+    r.pixel_data = (CHAR_INFO*)InterlockedExchangePointer(
+        (PVOID volatile*)&r.mailbox, r.pixel_data);
+    InterlockedExchange(&r.frame_ready, 1);
+    SetEvent(r.hFrameEvent);
+}
+
+DWORD WINAPI Render_ThreadProc(LPVOID param) {
+    (void)param;
+    while (g.is_running) {
+        WaitForSingleObject(r.hFrameEvent, 100);
+
+        // Only swap when the mailbox actually holds a fresh frame; if the
+        // main thread outpaces us, intermediate frames are simply skipped.
+        if (InterlockedExchange(&r.frame_ready, 0)) {
+            r.display_frame = (CHAR_INFO*)InterlockedExchangePointer(
+                (PVOID volatile*)&r.mailbox, r.display_frame);
+
+            LARGE_INTEGER p0, p1;
+            QueryPerformanceCounter(&p0);
+            Render_Present(r.display_frame);
+            if (cast.listening) Cast_PublishFrame(r.display_frame);
+            QueryPerformanceCounter(&p1);
+            InterlockedExchange(&prof.present_us,
+                (LONG)((p1.QuadPart - p0.QuadPart) * 1000000 / perf_freq.QuadPart));
+        }
+    }
+    return 0;
+}
+
+// --- VT escape-sequence backend -------------------------------------------------------
+
+// Win32 color nibbles order the channels B,G,R; ANSI orders them R,G,B
+static const unsigned char vt_ansi_color[8] = { 0, 4, 2, 6, 1, 5, 3, 7 };
+
+// Append the SGR code selecting a Win32 attribute's colors. Built with
+// the Fmt kernel: no CRT formatted I/O on the frame path, per the HUD
+// cache's contract.
+static int Vt_EmitSgr(char* out, WORD attr) {
+    int fg = (attr & FOREGROUND_INTENSITY ? 90 : 30) + vt_ansi_color[attr & 7];
+    int bg = (attr & BACKGROUND_INTENSITY ? 100 : 40) + vt_ansi_color[(attr >> 4) & 7];
+    int n = 0;
+    out[n++] = '\x1b';
+    out[n++] = '[';
+    n += Fmt_Int(out + n, fg);
+    out[n++] = ';';
+    n += Fmt_Int(out + n, bg);
+    out[n++] = 'm';
+    return n;
+}
+
+// Append one UTF-8 encoded BMP codepoint
+static int Vt_EmitUtf8(char* out, unsigned int cp) {
+    if (cp < 0x80) { out[0] = (char)cp; return 1; }
+    if (cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    out[0] = (char)(0xE0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[2] = (char)(0x80 | (cp & 0x3F));
+    return 3;
+}
+
+// Compose the whole frame into vt_buf — SGR codes only where the
+// attribute actually changes, so runs of one color cost one code —
+// then flush it with a single write
+static void Render_PresentVT(CHAR_INFO* frame) {
+    char* out = r.vt_buf;
+    size_t len = 0;
+
+    memcpy(out, "\x1b[H", 3); // Home the cursor; no clear, we repaint every cell
+    len += 3;
+
+    WORD last_attr = 0xFFFF;
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        CHAR_INFO* row = frame + Screen_Index(0, y);
+        if (y > 0) { out[len++] = '\r'; out[len++] = '\n'; }
+
+        for (int x = 0; x < SCREEN_WIDTH; x++) {
+            if (row[x].Attributes != last_attr) {
+                last_attr = row[x].Attributes;
+                len += Vt_EmitSgr(out + len, last_attr);
+            }
+            unsigned int cp = row[x].Char.UnicodeChar;
+            len += Vt_EmitUtf8(out + len, cp ? cp : ' ');
+
+            // Headroom check: SGR + glyph is at most ~14 bytes
+            if (len > VT_BUF_SIZE - 16) goto flush;
+        }
+    }
+
+flush:
+    if (!r.headless) {
+        DWORD written;
+        WriteFile(r.hVtOut, r.vt_buf, (DWORD)len, &written, NULL);
+    }
+    r.bytes_written += len;
+}
+
+void Render_Present(CHAR_INFO* frame) {
+    if (r.use_vt) {
+        Render_PresentVT(frame);
+        return;
+    }
+
+    int b = r.back_buffer_index;
     COORD size = { SCREEN_WIDTH, SCREEN_HEIGHT };
-    COORD origin = { 0, 0 };
-    SMALL_RECT region = { 0, 0, (SHORT)(SCREEN_WIDTH - 1), (SHORT)(SCREEN_HEIGHT - 1) };
-    
-    WriteConsoleOutputW(
-        r.hBuffer[r.back_buffer_index],
-        r.pixel_data,
-        size,
-        origin,
-        &region
-    );
-    
+
+    if (!r.shadow_valid[b]) {
+        // First frame into this buffer: push everything
+        COORD origin = { 0, 0 };
+        SMALL_RECT region = { 0, 0, (SHORT)(SCREEN_WIDTH - 1), (SHORT)(SCREEN_HEIGHT - 1) };
+        if (!r.headless) WriteConsoleOutputW(r.hBuffer[b], frame, size, origin, &region);
+        r.bytes_written += sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT;
+        r.shadow_valid[b] = true;
+    } else {
+        // Diff against what this buffer last displayed and only write dirty spans.
+        // On a typical tick only a handful of cells change, so this turns one
+        // 2400-cell write into a few tiny region writes.
+        CHAR_INFO* shadow = r.shadow_data[b];
+        for (int y = 0; y < SCREEN_HEIGHT; y++) {
+            CHAR_INFO* cur_row = frame + Screen_Index(0, y);
+            CHAR_INFO* old_row = shadow + Screen_Index(0, y);
+
+            // Fast path: untouched row
+            if (memcmp(cur_row, old_row, sizeof(CHAR_INFO) * SCREEN_WIDTH) == 0) continue;
+
+            int x = 0;
+            while (x < SCREEN_WIDTH) {
+                // Find start of dirty span
+                if (cur_row[x].Char.UnicodeChar == old_row[x].Char.UnicodeChar &&
+                    cur_row[x].Attributes == old_row[x].Attributes) {
+                    x++;
+                    continue;
+                }
+                int start = x;
+                int end = x;     // Last dirty cell seen
+                int gap = 0;     // Clean cells since last dirty one
+                while (x < SCREEN_WIDTH && gap <= 4) { // Coalesce spans separated by small gaps
+                    if (cur_row[x].Char.UnicodeChar != old_row[x].Char.UnicodeChar ||
+                        cur_row[x].Attributes != old_row[x].Attributes) {
+                        end = x;
+                        gap = 0;
+                    } else {
+                        gap++;
+                    }
+                    x++;
+                }
+
+                COORD span_origin = { (SHORT)start, (SHORT)y };
+                SMALL_RECT span_region = { (SHORT)start, (SHORT)y, (SHORT)end, (SHORT)y };
+                if (!r.headless) WriteConsoleOutputW(r.hBuffer[b], frame, size, span_origin, &span_region);
+                r.bytes_written += sizeof(CHAR_INFO) * (end - start + 1);
+            }
+        }
+    }
+
+    // Remember what this buffer now shows
+    memcpy(r.shadow_data[b], frame, sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+
     // Flip Buffers
-    SetConsoleActiveScreenBuffer(r.hBuffer[r.back_buffer_index]);
+    if (!r.headless) SetConsoleActiveScreenBuffer(r.hBuffer[b]);
     r.back_buffer_index = !r.back_buffer_index;
 }
 
@@ -385,70 +1429,143 @@ void Input_Enqueue(Vec2 dir) {
         g.input.tail = (g.input.tail + 1) % INPUT_QUEUE_SIZE;
         g.input.count++;
     }
+
+    // Replay capture: queue-full drops replicate themselves on playback
+    // because the queue state is part of the deterministic simulation
+    if (g.scene == SCENE_GAME) {
+        unsigned char code = (dir.y == -1) ? REPLAY_EV_UP
+                           : (dir.y == 1)  ? REPLAY_EV_DOWN
+                           : (dir.x == -1) ? REPLAY_EV_LEFT
+                                           : REPLAY_EV_RIGHT;
+        Replay_RecordEvent(code);
+    }
+}
+
+// Runs on its own thread: blocks in ReadConsoleInput and publishes key
+// transitions into the SPSC ring. Never touches game state directly.
+DWORD WINAPI Input_ThreadProc(LPVOID param) {
+    (void)param;
+    INPUT_RECORD records[32];
+    DWORD count;
+
+    while (g.is_running) {
+        if (!ReadConsoleInputW(in.hInput, records, 32, &count)) break;
+
+        for (DWORD i = 0; i < count; i++) {
+            if (records[i].EventType != KEY_EVENT) continue;
+
+            LONG tail = in.ev_tail;
+            LONG next = (tail + 1) % KEY_EVENT_QUEUE_SIZE;
+            if (next == in.ev_head) continue; // Ring full — drop rather than block
+
+            in.events[tail].vk = records[i].Event.KeyEvent.wVirtualKeyCode;
+            in.events[tail].down = records[i].Event.KeyEvent.bKeyDown != 0;
+            MemoryBarrier(); // Payload visible before the index moves
+            in.ev_tail = next;
+        }
+    }
+    return 0;
 }
 
 void Input_Process() {
-    // Helper macro for key state
-    #define KEY_PRESSED(vk) (GetAsyncKeyState(vk) & 0x8000)
+    // Drain everything the input thread queued since last frame.
+    // The held-state table filters console auto-repeat: only real
+    // down-edges reach Input_HandleKey, so no Sleep debounce is needed.
+    while (in.ev_head != in.ev_tail) {
+        KeyEvent ev = in.events[in.ev_head];
+        MemoryBarrier();
+        in.ev_head = (in.ev_head + 1) % KEY_EVENT_QUEUE_SIZE;
+
+        bool was_down = in.key_down[ev.vk & 0xFF];
+        in.key_down[ev.vk & 0xFF] = ev.down;
+        if (ev.down && !was_down) Input_HandleKey(ev.vk);
+    }
+
+    // Dash is level-triggered, not edge-triggered: follow the live SHIFT state.
+    // Versus never dashes — both cabinets must tick at the same rate.
+    if (g.scene == SCENE_GAME && g.mode != MODE_VERSUS) {
+        bool dash = in.key_down[VK_SHIFT];
+        if (dash != g.is_dashing) {
+            Replay_RecordEvent(dash ? REPLAY_EV_DASH_ON : REPLAY_EV_DASH_OFF);
+        }
+        g.is_dashing = dash;
+    }
+}
 
+void Input_HandleKey(WORD vk) {
     // Global Toggles
-    if (KEY_PRESSED(VK_F3)) { g.debug_mode = !g.debug_mode; Sleep(200); }
+    if (vk == VK_F3) { g.debug_mode = !g.debug_mode; return; }
+    if (vk == VK_F4) { Profiler_DumpTrace(); return; }
+    if (vk == VK_F5) { Replay_Save(); return; }
 
     // Scene Specific Input
     switch (g.scene) {
         case SCENE_MENU:
-            if (KEY_PRESSED('1')) { g.mode = MODE_CLASSIC; g.scene = SCENE_GAME; Game_Reset(); }
-            if (KEY_PRESSED('2')) { g.mode = MODE_OBSTACLES; g.scene = SCENE_GAME; Game_Reset(); }
-            if (KEY_PRESSED('H')) { g.scene = SCENE_SCORES; }
-            if (KEY_PRESSED('Q')) { g.is_running = false; }
-            Sleep(50); // Small debounce
+            if (vk == '1') { g.mode = MODE_CLASSIC; g.scene = SCENE_GAME; Game_Reset(); }
+            if (vk == '2') { g.mode = MODE_OBSTACLES; g.scene = SCENE_GAME; Game_Reset(); }
+            if (vk == '3') { g.mode = MODE_SURVIVAL; g.scene = SCENE_GAME; Game_Reset(); }
+            if (vk == '4') { g.mode = MODE_SPEEDRUN; g.scene = SCENE_GAME; Game_Reset(); }
+            if (vk == 'H') { g.scene = SCENE_SCORES; }
+            if (vk == 'Q') { g.is_running = false; }
             break;
 
         case SCENE_SCORES:
-            if (KEY_PRESSED(VK_ESCAPE)) { g.scene = SCENE_MENU; Sleep(200); }
+            if (vk == VK_ESCAPE) { g.scene = SCENE_MENU; }
             break;
 
         case SCENE_GAMEOVER:
             // Name Entry Logic
-            for (int k = 'A'; k <= 'Z'; k++) {
-                if (KEY_PRESSED(k)) {
-                    if (g.name_cursor < 10) {
-                        g.player_name[g.name_cursor++] = (char)k;
-                        g.player_name[g.name_cursor] = '\0';
-                        Sleep(150);
-                    }
-                }
+            if (vk >= 'A' && vk <= 'Z' && g.name_cursor < 10) {
+                g.player_name[g.name_cursor++] = (char)vk;
+                g.player_name[g.name_cursor] = '\0';
             }
-            if (KEY_PRESSED(VK_BACK) && g.name_cursor > 0) {
+            if (vk == VK_BACK && g.name_cursor > 0) {
                 g.player_name[--g.name_cursor] = '\0';
-                Sleep(150);
             }
-            if (KEY_PRESSED(VK_RETURN) && g.name_cursor > 0) {
+            if (vk == VK_RETURN && g.name_cursor > 0) {
                 Score_Add(g.player_name, g.score);
                 Score_Save();
                 g.scene = SCENE_SCORES;
-                Sleep(200);
             }
             break;
 
-        case SCENE_GAME:
-            if (KEY_PRESSED(VK_ESCAPE)) { g.scene = SCENE_MENU; }
-            if (KEY_PRESSED('P')) { g.is_paused = !g.is_paused; Sleep(200); }
-            
-            // Dash Logic
-            g.is_dashing = KEY_PRESSED(VK_SHIFT);
+        case SCENE_GAME: {
+            if (vk == VK_ESCAPE) {
+                if (net.active) Net_Shutdown(); // Tell the peer before leaving
+                g.scene = SCENE_MENU;
+                return;
+            }
+            if (vk == 'P') {
+                if (g.mode != MODE_VERSUS) g.is_paused = !g.is_paused; // Can't pause the peer
+                return;
+            }
 
             // Movement Logic
             Vec2 new_dir = {0, 0};
             bool input_found = false;
 
-            if (KEY_PRESSED(VK_UP) || KEY_PRESSED('W'))    { new_dir.x = 0; new_dir.y = -1; input_found = true; }
-            if (KEY_PRESSED(VK_DOWN) || KEY_PRESSED('S'))  { new_dir.x = 0; new_dir.y = 1; input_found = true; }
-            if (KEY_PRESSED(VK_LEFT) || KEY_PRESSED('A'))  { new_dir.x = -1; new_dir.y = 0; input_found = true; }
-            if (KEY_PRESSED(VK_RIGHT) || KEY_PRESSED('D')) { new_dir.x = 1; new_dir.y = 0; input_found = true; }
+            if (vk == VK_UP || vk == 'W')    { new_dir.x = 0; new_dir.y = -1; input_found = true; }
+            if (vk == VK_DOWN || vk == 'S')  { new_dir.x = 0; new_dir.y = 1; input_found = true; }
+            if (vk == VK_LEFT || vk == 'A')  { new_dir.x = -1; new_dir.y = 0; input_found = true; }
+            if (vk == VK_RIGHT || vk == 'D') { new_dir.x = 1; new_dir.y = 0; input_found = true; }
+            if (!input_found) return;
+
+            // Versus bypasses the local input queue: the change is stamped
+            // for a future tick and executed from the shared event log on
+            // both machines (180 filtering happens at execution, where the
+            // two simulations agree on the snake's state)
+            if (net.active) {
+                unsigned char code;
+                if (new_dir.y == -1)     code = REPLAY_EV_UP;
+                else if (new_dir.y == 1) code = REPLAY_EV_DOWN;
+                else if (new_dir.x == -1) code = REPLAY_EV_LEFT;
+                else                      code = REPLAY_EV_RIGHT;
+                Net_QueueLocal(code);
+                return;
+            }
 
             // Handle "Press to Start"
-            if (!g.has_started && input_found) {
+            if (!g.has_started) {
                 // Prevent starting by reversing into default body (assumed spawning left-to-right)
                 if (new_dir.x != -1) {
                     g.has_started = true;
@@ -457,7 +1574,7 @@ void Input_Process() {
                 }
             }
             // Handle Active Gameplay Input
-            else if (g.has_started && input_found) {
+            else {
                 // Peek last queued input to prevent 180 turns
                 Vec2 last_dir = g.snake.dir;
                 if (g.input.count > 0) {
@@ -472,114 +1589,422 @@ void Input_Process() {
                 }
             }
             break;
+        }
     }
 }
 
 // ======================================================================================
-// GAMEPLAY LOGIC
+// RNG SERVICE
 // ======================================================================================
 
-void Level_Generate(GameMode mode) {
-    memset(g.map, 0, sizeof(g.map));
+void Rng_Seed(Rng* rng, unsigned long long seed) {
+    rng->state = seed ? seed : 0x9E3779B97F4A7C15ull; // Never all-zero
+}
 
-    // 1. Draw Border
-    for(int x=0; x<SCREEN_WIDTH; x++) { g.map[x][0] = 1; g.map[x][SCREEN_HEIGHT-1] = 1; }
-    for(int y=0; y<SCREEN_HEIGHT; y++) { g.map[0][y] = 1; g.map[SCREEN_WIDTH-1][y] = 1; }
+unsigned int Rng_Next(Rng* rng) {
+    // splitmix64 step: one add, two xor-shift-multiplies, no locking
+    unsigned long long z = (rng->state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return (unsigned int)((z ^ (z >> 31)) >> 32);
+}
 
-    // 2. Generate Obstacles (if mode selected)
-    if (mode == MODE_OBSTACLES) {
-        int count = 20 + rand() % 10;
-        for (int i = 0; i < count; i++) {
-            int w = 2 + rand() % 6;
-            int h = 1 + rand() % 4;
-            int x = 2 + rand() % (SCREEN_WIDTH - w - 2);
-            int y = 2 + rand() % (SCREEN_HEIGHT - h - 2);
-            
-            // Simple block filling
-            for(int bx=0; bx<w; bx++) {
-                for(int by=0; by<h; by++) {
-                    g.map[x+bx][y+by] = 1;
-                }
-            }
-        }
-    }
+unsigned int Rng_Range(Rng* rng, unsigned int n) {
+    // Modulo bias is negligible against a full 32-bit draw for our ranges
+    return n ? Rng_Next(rng) % n : 0;
 }
 
-void Game_Reset() {
-    g.score = 0;
-    g.combo_multiplier = 1;
-    g.combo_timer = 0;
-    g.has_started = false;
-    g.is_paused = false;
-    g.is_dashing = false;
-    g.input.count = g.input.head = g.input.tail = 0;
+void Rng_Fill(Rng* rng, unsigned int* out, int count) {
+    for (int i = 0; i < count; i++) out[i] = Rng_Next(rng);
+}
 
-    // Reset Snake
-    g.snake.length = 4;
-    g.snake.grow_pending = 0;
-    g.snake.dir = (Vec2){1, 0};
-    g.snake.color_theme = COL_GREEN;
-    
-    // Spawn in center
-    int sx = SCREEN_WIDTH / 2;
-    int sy = SCREEN_HEIGHT / 2;
-    
-    Level_Generate(g.mode);
-    
-    // Clear Spawn Area
-    for(int x=sx-5; x<=sx+5; x++)
-        for(int y=sy-5; y<=sy+5; y++)
-            if (x>0 && x<SCREEN_WIDTH-1 && y>0 && y<SCREEN_HEIGHT-1)
-                g.map[x][y] = 0;
+// ======================================================================================
+// GAMEPLAY LOGIC
+// ======================================================================================
 
-    for(int i=0; i<g.snake.length; i++) {
-        g.snake.body[i].x = sx - i;
-        g.snake.body[i].y = sy;
+void Snake_AllocBodies() {
+    g.snake.body = (Vec2*)malloc(sizeof(Vec2) * MAX_SNAKE_LEN);
+    g.snake.cap_mask = MAX_SNAKE_LEN - 1;
+    for (int i = 0; i < MAX_AI_SNAKES; i++) {
+        g.ai[i].snake.body = (Vec2*)malloc(sizeof(Vec2) * MAX_AI_SNAKE_LEN);
+        g.ai[i].snake.cap_mask = MAX_AI_SNAKE_LEN - 1;
     }
+}
 
-    // Spawn First Food
-    do {
-        g.food.x = rand() % (SCREEN_WIDTH - 2) + 1;
-        g.food.y = rand() % (SCREEN_HEIGHT - 2) + 1;
-    } while (g.map[g.food.x][g.food.y] != 0);
+Vec2 Snake_SegmentOf(const Snake* s, int i) {
+    // Capacity is a power of two, so the mask replaces a modulo
+    return s->body[(s->head + i) & s->cap_mask];
 }
 
-void Game_UpdateFixed() {
-    // 1. Process Queued Input
-    if (g.input.count > 0) {
-        g.snake.dir = g.input.queue[g.input.head];
-        g.input.head = (g.input.head + 1) % INPUT_QUEUE_SIZE;
-        g.input.count--;
-    }
+Vec2 Snake_Segment(int i) {
+    return Snake_SegmentOf(&g.snake, i);
+}
 
-    // 2. Calculate Next Position
-    Vec2 head = g.snake.body[0];
-    Vec2 next = { head.x + g.snake.dir.x, head.y + g.snake.dir.y };
+// Where segment i sat one tick ago. A move shifts every segment one
+// slot down the body, so segment i's previous cell is segment i+1's
+// current one; the tail reads the vacated ring slot, which keeps its
+// value because moves write only the new head slot.
+Vec2 Snake_PrevSegmentOf(const Snake* s, int i) {
+    return s->body[(s->head + i + 1) & s->cap_mask];
+}
 
-    // 3. Collision Detection
-    bool collision = false;
-    
-    // Bounds & Walls
-    if (next.x < 0 || next.x >= SCREEN_WIDTH || next.y < 0 || next.y >= SCREEN_HEIGHT) collision = true;
-    else if (g.map[next.x][next.y] == 1) collision = true;
-    
-    // Self
-    for (int i = 0; i < g.snake.length - 1; i++) { // -1 to allow tail chasing
-        if (next.x == g.snake.body[i].x && next.y == g.snake.body[i].y) collision = true;
-    }
+// Fraction of the current tick already elapsed, for presentation
+// blending between previous-tick and current-tick positions
+float Game_InterpAlpha() {
+    if (!g.interp_valid || g.tick_interval <= 0) return 1.0f;
+    float a = (float)(g.time_accumulator / g.tick_interval);
+    return (a < 0.0f) ? 0.0f : (a > 1.0f) ? 1.0f : a;
+}
 
-    if (collision) {
-        g.scene = SCENE_GAMEOVER;
-        g.name_cursor = 0;
-        memset(g.player_name, 0, 16);
-        return;
+// Map an interpolated (sub-cell) position to a console cell plus a
+// half-block glyph hinting which side of the cell the entity is on
+wchar_t Interp_Glyph(float fx, float fy, int* cx, int* cy) {
+    *cx = (int)floorf(fx + 0.5f);
+    *cy = (int)floorf(fy + 0.5f);
+    float sx = fx - (float)*cx;
+    float sy = fy - (float)*cy;
+    if (sx < -0.17f) return 0x258C; // Left half
+    if (sx >  0.17f) return 0x2590; // Right half
+    if (sy < -0.17f) return 0x2580; // Upper half
+    if (sy >  0.17f) return 0x2584; // Lower half
+    return 0x2588;                  // Centered: full block
+}
+
+// --- Chunked wall layer ---------------------------------------------------------------
+
+unsigned char Map_Get(int x, int y) {
+    return g.chunks[y >> CHUNK_SHIFT][x >> CHUNK_SHIFT].cells[y & CHUNK_MASK][x & CHUNK_MASK];
+}
+
+void Map_Set(int x, int y, unsigned char v) {
+    g.chunks[y >> CHUNK_SHIFT][x >> CHUNK_SHIFT].cells[y & CHUNK_MASK][x & CHUNK_MASK] = v;
+}
+
+// --- Occupancy grid -------------------------------------------------------------------
+
+bool Grid_IsBlocked(int x, int y) {
+    int cell = Arena_Index(x, y);
+    return (g.occupancy[cell >> 5] >> (cell & 31)) & 1;
+}
+
+void Grid_Occupy(int x, int y) {
+    int cell = Arena_Index(x, y);
+    g.occupancy[cell >> 5] |= 1u << (cell & 31);
+
+    // Remove from free list (swap-with-last keeps it dense)
+    int slot = g.free_index[cell];
+    if (slot >= 0) {
+        int last = g.free_cells[--g.free_count];
+        g.free_cells[slot] = last;
+        g.free_index[last] = slot;
+        g.free_index[cell] = -1;
+    }
+}
+
+void Grid_Free(int x, int y) {
+    int cell = Arena_Index(x, y);
+    g.occupancy[cell >> 5] &= ~(1u << (cell & 31));
+
+    if (g.free_index[cell] < 0) {
+        g.free_index[cell] = g.free_count;
+        g.free_cells[g.free_count++] = cell;
+    }
+}
+
+bool Grid_RandomFreeCell(Vec2* out) {
+    if (g.free_count <= 0) return false; // Board full — nowhere left to spawn
+    int cell = g.free_cells[Rng_Range(&g.rng_world, g.free_count)];
+    out->x = cell % ARENA_WIDTH;
+    out->y = cell / ARENA_WIDTH;
+    return true;
+}
+
+// Unbounded flood fill over the wall layer starting at the spawn cell. The
+// BFS queue lives in g.free_cells, so the cells it reaches ARE the free-cell
+// pool once the pass finishes — no separate collection scan. Returns the
+// reached count; cells are marked in ai_visit under a fresh generation.
+int Level_Flood(int sx, int sy) {
+    ai_visit_gen++;
+    int head = 0, count = 0;
+    g.free_cells[count++] = Arena_Index(sx, sy);
+    ai_visit[Arena_Index(sx, sy)] = ai_visit_gen;
+
+    while (head < count) {
+        int cell = g.free_cells[head++];
+        int cx = cell % ARENA_WIDTH;
+        int cy = cell / ARENA_WIDTH;
+
+        static const int dx[4] = { 1, -1, 0, 0 };
+        static const int dy[4] = { 0, 0, 1, -1 };
+        for (int d = 0; d < 4; d++) {
+            int nx = cx + dx[d], ny = cy + dy[d];
+            int nc = Arena_Index(nx, ny);
+            if (ai_visit[nc] == ai_visit_gen) continue;
+            if (Map_Get(nx, ny)) continue; // Border is walled, so no bounds test
+            ai_visit[nc] = ai_visit_gen;
+            g.free_cells[count++] = nc;
+        }
+    }
+    return count;
+}
+
+// Generation validation stage: any open cell the flood from spawn cannot
+// reach is a walled-off pocket — food spawned there would be unwinnable.
+// For each pocket we carve an L-shaped corridor toward the spawn and flood
+// again until everything open is connected, then publish the final reached
+// list as the occupancy grid + free-cell pool.
+void Level_Validate(int sx, int sy) {
+    for (;;) {
+        g.free_count = Level_Flood(sx, sy);
+
+        // Find a pocket: open on the map, unreached by the flood
+        int px = -1, py = -1;
+        for (int y = 1; y < ARENA_HEIGHT - 1 && px < 0; y++)
+            for (int x = 1; x < ARENA_WIDTH - 1; x++)
+                if (!Map_Get(x, y) && ai_visit[Arena_Index(x, y)] != ai_visit_gen) {
+                    px = x; py = y;
+                    break;
+                }
+        if (px < 0) break; // Fully connected
+
+        // Carve straight to the spawn column, then up/down the column. Both
+        // endpoints are interior, so the path never touches the border.
+        while (px != sx) { px += (sx > px) ? 1 : -1; Map_Set(px, py, 0); }
+        while (py != sy) { py += (sy > py) ? 1 : -1; Map_Set(px, py, 0); }
+    }
+
+    // Everything not reached is a wall; everything reached is spawnable
+    memset(g.occupancy, 0xFF, sizeof(g.occupancy));
+    memset(g.free_index, -1, sizeof(g.free_index));
+    for (int i = 0; i < g.free_count; i++) {
+        int cell = g.free_cells[i];
+        g.occupancy[cell >> 5] &= ~(1u << (cell & 31));
+        g.free_index[cell] = i;
+    }
+}
+
+void Level_Generate(GameMode mode) {
+    memset(g.chunks, 0, sizeof(g.chunks));
+
+    // 1. Draw Border
+    for(int x=0; x<ARENA_WIDTH; x++) { Map_Set(x, 0, 1); Map_Set(x, ARENA_HEIGHT-1, 1); }
+    for(int y=0; y<ARENA_HEIGHT; y++) { Map_Set(0, y, 1); Map_Set(ARENA_WIDTH-1, y, 1); }
+
+    // 2. Generate Obstacles (if mode selected), density scaled to arena area
+    if (mode == MODE_OBSTACLES) {
+        int count = (20 + Rng_Range(&g.rng_world, 10)) * (ARENA_CELLS / (SCREEN_WIDTH * SCREEN_HEIGHT));
+
+        // Bulk-draw the randomness in batches: 4 values per obstacle
+        unsigned int* vals = (unsigned int*)Arena_Alloc(&arena_level, sizeof(unsigned int) * 4 * 256);
+        while (vals && count > 0) {
+            int batch = (count < 256) ? count : 256;
+            Rng_Fill(&g.rng_world, vals, batch * 4);
+
+            for (int i = 0; i < batch; i++) {
+                int w = 2 + vals[i*4 + 0] % 6;
+                int h = 1 + vals[i*4 + 1] % 4;
+                int x = 2 + vals[i*4 + 2] % (ARENA_WIDTH - w - 2);
+                int y = 2 + vals[i*4 + 3] % (ARENA_HEIGHT - h - 2);
+
+                // Simple block filling
+                for(int bx=0; bx<w; bx++) {
+                    for(int by=0; by<h; by++) {
+                        Map_Set(x+bx, y+by, 1);
+                    }
+                }
+            }
+            count -= batch;
+        }
     }
 
-    // 4. Move Snake (Shift segments)
-    for (int i = g.snake.length; i > 0; i--) {
-        g.snake.body[i] = g.snake.body[i - 1];
+    // 3. Clear Spawn Area (snake starts in the center)
+    int sx = ARENA_WIDTH / 2;
+    int sy = ARENA_HEIGHT / 2;
+    for(int x=sx-5; x<=sx+5; x++)
+        for(int y=sy-5; y<=sy+5; y++)
+            if (x>0 && x<ARENA_WIDTH-1 && y>0 && y<ARENA_HEIGHT-1)
+                Map_Set(x, y, 0);
+
+    // 4. Connectivity pass: reconnect walled-off pockets and emit the
+    // reachable-cell list as the food spawner's free pool
+    Level_Validate(sx, sy);
+
+    // 5. Bake the finished map into the static background layer
+    Render_BakeBackground();
+}
+
+void Game_Reset() {
+    // Seed the run RNG streams: playback restores the recorded seed,
+    // netplay uses the one agreed at handshake; other live runs draw a
+    // fresh one and start a new recording
+    if (!replay.playing && !net.active) {
+        LARGE_INTEGER entropy;
+        QueryPerformanceCounter(&entropy);
+        replay.seed = (unsigned int)time(NULL) ^ (unsigned int)entropy.QuadPart;
+        replay.recording = true;
+        replay.count = 0;
+        replay.last_event_tick = 0;
+        replay.mode = (unsigned char)g.mode;
     }
-    g.snake.body[0] = next;
+    Rng_Seed(&g.rng_world, replay.seed);
+    Rng_Seed(&g.rng_fx, (unsigned long long)replay.seed * 0x9E3779B9u + 1);
+    Rng_Seed(&g.rng_ai, (unsigned long long)replay.seed * 0x85EBCA6Bu + 2);
+    g.tick_count = 0;
+    g.run_time_us = 0;
+    g.splits_taken = 0;
+    memset(g.split_us, 0, sizeof(g.split_us));
+
+    g.score = 0;
+    g.combo_multiplier = 1;
+    g.combo_timer = 0;
+    g.has_started = false;
+    g.is_paused = false;
+    g.is_dashing = false;
+    g.input.count = g.input.head = g.input.tail = 0;
+
+    // Reset Snake
+    g.snake.length = 4;
+    g.snake.grow_pending = 0;
+    g.snake.dir = (Vec2){1, 0};
+    g.snake.color_theme = COL_GREEN;
+    
+    // Spawn in center of the arena; versus offsets each player into their
+    // own row of the cleared spawn block (host above, client below)
+    int sx = ARENA_WIDTH / 2;
+    int sy = ARENA_HEIGHT / 2;
+    if (g.mode == MODE_VERSUS) sy += net.host ? -4 : 4;
+
+    // Per-level scratch: drop last level's allocations and carve anew.
+    // LEVEL_ARENA_SIZE is sized so these cannot fail.
+    Arena_Reset(&arena_level);
+    ai_visit = (int*)Arena_Alloc(&arena_level, sizeof(int) * ARENA_CELLS);
+    ai_queue = (int*)Arena_Alloc(&arena_level, sizeof(int) * AI_FLOOD_LIMIT);
+    memset(ai_visit, 0, sizeof(int) * ARENA_CELLS);
+    ai_visit_gen = 0;
+
+    Level_Generate(g.mode);
+
+    g.snake.head = 0;
+    // One slot past the tail is written too: interpolation reads it as
+    // the tail's previous-tick cell before the first move
+    for(int i=0; i<=g.snake.length; i++) {
+        g.snake.body[i].x = sx - i;
+        g.snake.body[i].y = sy;
+    }
+
+    // Versus: stage the peer's snake in the mirrored spawn row. Its body
+    // ring is swapped for a player-sized one so both simulations apply
+    // the identical growth cap to the same snake.
+    if (g.mode == MODE_VERSUS) {
+        AiAgent* a = &g.ai[0];
+        Snake* s = &a->snake;
+        if (s->cap_mask != MAX_SNAKE_LEN - 1) {
+            free(s->body);
+            s->body = (Vec2*)malloc(sizeof(Vec2) * MAX_SNAKE_LEN);
+            s->cap_mask = MAX_SNAKE_LEN - 1;
+        }
+        s->head = 0;
+        s->length = 4;
+        s->grow_pending = 0;
+        s->dir = (Vec2){1, 0};
+        s->color_theme = COL_CYAN;
+        int py = ARENA_HEIGHT / 2 + (net.host ? 4 : -4);
+        for (int i = 0; i <= s->length; i++) {
+            s->body[i].x = sx - i;
+            s->body[i].y = py;
+        }
+        a->alive = true;
+        g.ai_count = 1;
+        g.ai_cursor = 0;
+        g.has_started = true; // Lockstep runs from tick 0 on both sides
+        net.local_won = false;
+        net.local_count = net.local_applied = 0;
+        net.remote_count = net.remote_applied = 0;
+        net.remote_tick = 0;
+        net.local_acked = 0;
+    }
+
+    // Occupy the snakes' cells (Level_Validate already published the
+    // walls + free pool), then spawn the first food from the pool. In
+    // versus the free list must be perturbed in the same order on both
+    // machines, so the host snake is always inserted first.
+    Snake* occupy_order[2] = { &g.snake, NULL };
+    if (g.mode == MODE_VERSUS) {
+        occupy_order[0] = net.host ? &g.snake : &g.ai[0].snake;
+        occupy_order[1] = net.host ? &g.ai[0].snake : &g.snake;
+    }
+    for (int k = 0; k < 2; k++) {
+        if (!occupy_order[k]) continue;
+        for (int i = 0; i < occupy_order[k]->length; i++) {
+            Vec2 seg = Snake_SegmentOf(occupy_order[k], i);
+            Grid_Occupy(seg.x, seg.y);
+        }
+    }
+    Grid_RandomFreeCell(&g.food);
+
+    // Stage AI opponents (spawn staggered over the first ticks)
+    if (g.mode == MODE_SURVIVAL) AI_ResetAll();
+    else if (g.mode != MODE_VERSUS) g.ai_count = 0;
+}
+
+void Game_UpdateFixed() {
+    // 0. Tick accounting in whole microseconds of simulated time. A dash
+    // tick represents half a base tick of real time, so summing the
+    // executed intervals stays drift-free however the rates interleave —
+    // and the total is independent of render performance by construction.
+    unsigned long long tick_us = (unsigned long long)(BASE_TICK_RATE * 1000000.0 + 0.5);
+    if (g.is_dashing) tick_us = (unsigned long long)(tick_us / DASH_MULTIPLIER + 0.5);
+    g.run_time_us += tick_us;
+
+    // Versus, client side: the host snake simulates first each tick so
+    // both machines mutate the shared world in the same global order
+    if (g.mode == MODE_VERSUS && !net.host) {
+        Net_StepRemote();
+        if (g.scene != SCENE_GAME) return; // Peer died this tick
+    }
+
+    // 1. Process Queued Input. Versus executes from the tick-stamped
+    // event log instead, identically on both machines.
+    if (g.mode == MODE_VERSUS) {
+        Net_ApplyEvents(net.local_log, net.local_count, &net.local_applied, &g.snake);
+    } else if (g.input.count > 0) {
+        g.snake.dir = g.input.queue[g.input.head];
+        g.input.head = (g.input.head + 1) % INPUT_QUEUE_SIZE;
+        g.input.count--;
+    }
+
+    // 2. Calculate Next Position
+    Vec2 head = Snake_Segment(0);
+    Vec2 next = { head.x + g.snake.dir.x, head.y + g.snake.dir.y };
+
+    // 3. Collision Detection
+    bool collision = false;
+    
+    // Bounds, Walls & Self — one bit test via the occupancy grid
+    Vec2 tail = Snake_Segment(g.snake.length - 1);
+    if (next.x < 0 || next.x >= ARENA_WIDTH || next.y < 0 || next.y >= ARENA_HEIGHT) collision = true;
+    else if (Grid_IsBlocked(next.x, next.y)) {
+        // Moving onto the tail cell is allowed (it vacates this same tick)
+        if (next.x != tail.x || next.y != tail.y) collision = true;
+    }
+
+    if (collision) {
+        g.scene = SCENE_GAMEOVER;
+        g.name_cursor = 0;
+        memset(g.player_name, 0, 16);
+        // Versus: the round is resolved (the peer reaches the same verdict
+        // from its own simulation). Drop the session now so later runs
+        // reseed normally and are no longer gated on the lockstep pump.
+        if (g.mode == MODE_VERSUS) Net_Shutdown();
+        return;
+    }
+
+    // 4. Move Snake (Ring buffer: step head back, old tail cell keeps its value
+    // so growth in step 6 re-includes it — same semantics as the old shift)
+    Grid_Free(tail.x, tail.y); // Tail vacates; step 6 re-occupies it if we grow
+    g.snake.head = (g.snake.head - 1) & g.snake.cap_mask;
+    g.snake.body[g.snake.head] = next;
+    Grid_Occupy(next.x, next.y);
 
     // 5. Food Interaction
     if (next.x == g.food.x && next.y == g.food.y) {
@@ -604,24 +2029,26 @@ void Game_UpdateFixed() {
         else if (g.score > 250) g.snake.color_theme = COL_CYAN;
         else if (g.score > 100) g.snake.color_theme = COL_YELLOW;
 
-        // Respawn Food
-        bool valid = false;
-        while (!valid) {
-            valid = true;
-            g.food.x = rand() % (SCREEN_WIDTH - 2) + 1;
-            g.food.y = rand() % (SCREEN_HEIGHT - 2) + 1;
-            if (g.map[g.food.x][g.food.y] != 0) valid = false;
-            for(int i=0; i<g.snake.length; i++) 
-                if(g.snake.body[i].x == g.food.x && g.snake.body[i].y == g.food.y) valid = false;
+        // Speedrun splits fall at the same thresholds; a big eat can
+        // cross more than one at once
+        while (g.splits_taken < SPEEDRUN_SPLITS &&
+               g.score > speedrun_milestones[g.splits_taken]) {
+            g.split_us[g.splits_taken] = g.run_time_us;
+            g.splits_taken++;
         }
+
+        // Respawn Food — uniform pick from the maintained free-cell list
+        Grid_RandomFreeCell(&g.food);
     }
 
     // 6. Growth Processing
-    if (g.snake.grow_pending > 0) {
+    if (g.snake.grow_pending > 0 && g.snake.length <= g.snake.cap_mask) {
         g.snake.length++;
         g.snake.grow_pending--;
+        Vec2 new_tail = Snake_Segment(g.snake.length - 1);
+        Grid_Occupy(new_tail.x, new_tail.y); // The vacated cell is part of the body again
     }
-    
+
     // 7. Combo Decay
     if (g.combo_timer > 0) {
         g.combo_timer--;
@@ -629,6 +2056,181 @@ void Game_UpdateFixed() {
             g.combo_multiplier = 1; // Reset combo
         }
     }
+
+    // 8. AI Opponents (survival mode)
+    if (g.mode == MODE_SURVIVAL) {
+        AI_UpdateAll();
+    }
+
+    // Versus, host side: the client snake simulates second
+    if (g.mode == MODE_VERSUS && net.host) {
+        Net_StepRemote();
+        if (g.scene != SCENE_GAME) return;
+    }
+
+    g.tick_count++;
+}
+
+// ======================================================================================
+// AI OPPONENTS
+// ======================================================================================
+
+void AI_ResetAll() {
+    static const WORD ai_colors[] = { COL_BLUE, COL_CYAN, COL_MAGENTA, COL_YELLOW, COL_WHITE };
+
+    g.ai_count = AI_SNAKE_COUNT;
+    g.ai_cursor = 0;
+    for (int i = 0; i < g.ai_count; i++) {
+        g.ai[i].alive = false;
+        g.ai[i].respawn_timer = 1 + (i * 5); // Stagger arrivals
+        g.ai[i].snake.color_theme = ai_colors[i % 5];
+        g.ai[i].planned_dir = (Vec2){1, 0};
+    }
+}
+
+// Bounded BFS over free cells starting at (x,y); returns how many cells
+// were reached before hitting the limit. Cheap dead-end detector.
+int AI_FloodCount(int x, int y, int limit) {
+    if (limit > AI_FLOOD_LIMIT) limit = AI_FLOOD_LIMIT;
+    if (limit <= 0) return 0;
+
+    ai_visit_gen++;
+    int head = 0, count = 0;
+    ai_queue[count++] = Arena_Index(x, y);
+    ai_visit[Arena_Index(x, y)] = ai_visit_gen;
+
+    while (head < count && count < limit) {
+        int cell = ai_queue[head++];
+        int cx = cell % ARENA_WIDTH;
+        int cy = cell / ARENA_WIDTH;
+
+        static const int dx[4] = { 1, -1, 0, 0 };
+        static const int dy[4] = { 0, 0, 1, -1 };
+        for (int d = 0; d < 4 && count < limit; d++) {
+            int nx = cx + dx[d], ny = cy + dy[d];
+            if (nx < 0 || nx >= ARENA_WIDTH || ny < 0 || ny >= ARENA_HEIGHT) continue;
+            int nc = Arena_Index(nx, ny);
+            if (ai_visit[nc] == ai_visit_gen) continue;
+            if (Grid_IsBlocked(nx, ny)) continue;
+            ai_visit[nc] = ai_visit_gen;
+            ai_queue[count++] = nc;
+        }
+    }
+    ai_flood_spent += count;
+    return count;
+}
+
+// Greedy food seeking with an optional reachability probe. When the tick
+// budget is spent, callers pass allow_search = false and we settle for
+// the first non-blocked candidate.
+Vec2 AI_PlanDir(AiAgent* a, bool allow_search) {
+    Snake* s = &a->snake;
+    Vec2 head = Snake_SegmentOf(s, 0);
+    Vec2 tail = Snake_SegmentOf(s, s->length - 1);
+    int dx = g.food.x - head.x;
+    int dy = g.food.y - head.y;
+
+    Vec2 cands[4];
+    Vec2 step_x = { (dx >= 0) ? 1 : -1, 0 };
+    Vec2 step_y = { 0, (dy >= 0) ? 1 : -1 };
+    if (abs(dx) >= abs(dy)) { cands[0] = step_x; cands[1] = step_y; }
+    else                    { cands[0] = step_y; cands[1] = step_x; }
+    cands[2] = (Vec2){ -cands[1].x, -cands[1].y };
+    cands[3] = (Vec2){ -cands[0].x, -cands[0].y };
+
+    Vec2 first_open = s->dir;
+    bool have_open = false;
+
+    for (int i = 0; i < 4; i++) {
+        Vec2 c = cands[i];
+        if (s->length > 1 && c.x == -s->dir.x && c.y == -s->dir.y) continue; // No 180s
+        int nx = head.x + c.x, ny = head.y + c.y;
+        if (nx < 0 || nx >= ARENA_WIDTH || ny < 0 || ny >= ARENA_HEIGHT) continue;
+        if (Grid_IsBlocked(nx, ny) && (nx != tail.x || ny != tail.y)) continue;
+
+        if (!have_open) { first_open = c; have_open = true; }
+        if (!allow_search) return c;
+
+        // Reject moves into pockets smaller than our own body
+        int need = (s->length < AI_FLOOD_LIMIT) ? s->length : AI_FLOOD_LIMIT;
+        if (AI_FloodCount(nx, ny, need) >= need) return c;
+    }
+    return first_open; // All candidates look cramped — take the least bad
+}
+
+void AI_UpdateAll() {
+    ai_flood_spent = 0;
+
+    for (int k = 0; k < g.ai_count; k++) {
+        AiAgent* a = &g.ai[(g.ai_cursor + k) % g.ai_count];
+        Snake* s = &a->snake;
+
+        if (!a->alive) {
+            if (--a->respawn_timer <= 0) {
+                Vec2 spawn;
+                if (!Grid_RandomFreeCell(&spawn)) continue; // Arena full, try later
+                s->head = 0;
+                s->body[0] = spawn;
+                s->body[1] = spawn; // Tail's "previous" cell for interpolation
+                s->length = 1;
+                s->grow_pending = 3;
+                s->dir = (Vec2){ (Rng_Next(&g.rng_ai) & 1) ? 1 : -1, 0 };
+                Grid_Occupy(spawn.x, spawn.y);
+                a->alive = true;
+            }
+            continue;
+        }
+
+        // Planning shares one expansion budget per tick; the round-robin
+        // cursor rotates which agents get the expensive search when it
+        // runs out. Counting expansions keeps the decision deterministic,
+        // so recorded survival runs re-simulate identically.
+        a->planned_dir = AI_PlanDir(a, ai_flood_spent < AI_TICK_FLOOD_BUDGET);
+        s->dir = a->planned_dir;
+
+        Vec2 head = Snake_SegmentOf(s, 0);
+        Vec2 next = { head.x + s->dir.x, head.y + s->dir.y };
+        Vec2 tail = Snake_SegmentOf(s, s->length - 1);
+
+        bool dead = false;
+        if (next.x < 0 || next.x >= ARENA_WIDTH || next.y < 0 || next.y >= ARENA_HEIGHT) dead = true;
+        else if (Grid_IsBlocked(next.x, next.y)) {
+            if (next.x != tail.x || next.y != tail.y) dead = true;
+        }
+
+        if (dead) {
+            // Release the body back to the free list and queue a respawn
+            for (int i = 0; i < s->length; i++) {
+                Vec2 seg = Snake_SegmentOf(s, i);
+                Grid_Free(seg.x, seg.y);
+            }
+            a->alive = false;
+            a->respawn_timer = AI_RESPAWN_TICKS;
+            continue;
+        }
+
+        // Move through the shared occupancy grid, same sequence as the player
+        Grid_Free(tail.x, tail.y);
+        s->head = (s->head - 1) & s->cap_mask;
+        s->body[s->head] = next;
+        Grid_Occupy(next.x, next.y);
+
+        // AI competes for the same food
+        if (next.x == g.food.x && next.y == g.food.y) {
+            s->grow_pending++;
+            Particles_Spawn(next.x, next.y, 10, s->color_theme);
+            Grid_RandomFreeCell(&g.food);
+        }
+
+        if (s->grow_pending > 0 && s->length <= s->cap_mask) {
+            s->length++;
+            s->grow_pending--;
+            Vec2 new_tail = Snake_SegmentOf(s, s->length - 1);
+            Grid_Occupy(new_tail.x, new_tail.y);
+        }
+    }
+
+    if (g.ai_count > 0) g.ai_cursor = (g.ai_cursor + 1) % g.ai_count;
 }
 
 // ======================================================================================
@@ -636,163 +2238,1730 @@ void Game_UpdateFixed() {
 // ======================================================================================
 
 void Particles_Spawn(int x, int y, int count, WORD color) {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (g.particles[i].life <= 0 && count > 0) {
-            g.particles[i].pos = (Vec2){x, y};
-            g.particles[i].vel.x = (rand() % 3) - 1;
-            g.particles[i].vel.y = (rand() % 3) - 1;
-            g.particles[i].life = 5 + rand() % 10;
-            g.particles[i].color = color;
-            g.particles[i].icon = (rand() % 2) ? '*' : '+';
-            count--;
+    ParticleSystem* p = &g.particles;
+
+    // The live region is dense, so a free slot is simply the next index.
+    // Bursts draw their randomness in one bulk call per batch, staged in
+    // the frame arena (effects degrade silently if it ever fills).
+    unsigned int* vals = (unsigned int*)Arena_Alloc(&arena_frame, sizeof(unsigned int) * 4 * 64);
+    if (!vals) return;
+    while (count > 0 && p->live_count < MAX_PARTICLES) {
+        int batch = (count < 64) ? count : 64;
+        if (batch > MAX_PARTICLES - p->live_count) batch = MAX_PARTICLES - p->live_count;
+        Rng_Fill(&g.rng_fx, vals, batch * 4);
+
+        for (int b = 0; b < batch; b++) {
+            int i = p->live_count++;
+            p->pos_x[i] = (float)x + 0.5f;
+            p->pos_y[i] = (float)y + 0.5f;
+            p->prev_x[i] = p->pos_x[i];
+            p->prev_y[i] = p->pos_y[i];
+            // Fractional velocities: random horizontal spread, upward pop
+            // that gravity pulls back down over the particle's lifetime
+            p->vel_x[i] = ((int)(vals[b*4 + 0] % 2001) - 1000) * 0.0008f;
+            p->vel_y[i] = -0.1f - (vals[b*4 + 1] % 1000) * 0.0005f;
+            p->life[i] = (short)(10 + vals[b*4 + 2] % 15);
+            p->color[i] = color;
+            p->icon[i] = (vals[b*4 + 3] % 2) ? '*' : '+';
         }
+        count -= batch;
     }
 }
 
 void Particles_Update() {
-    for (int i = 0; i < MAX_PARTICLES; i++) {
-        if (g.particles[i].life > 0) {
-            g.particles[i].pos.x += g.particles[i].vel.x;
-            g.particles[i].pos.y += g.particles[i].vel.y;
-            g.particles[i].life--;
+    ParticleSystem* p = &g.particles;
+    int n = p->live_count;
+
+    // Snapshot positions before integrating; Game_Draw blends from these
+    memcpy(p->prev_x, p->pos_x, sizeof(float) * n);
+    memcpy(p->prev_y, p->pos_y, sizeof(float) * n);
+
+    // Pass 1: integrate motion. Contiguous arrays, no per-element
+    // branches — drag then gravity then position, over every live slot.
+#if PARTICLE_SSE2
+    {
+        __m128 drag = _mm_set1_ps(PARTICLE_DRAG);
+        __m128 grav = _mm_set1_ps(PARTICLE_GRAVITY);
+        int i = 0;
+        for (; i + 4 <= n; i += 4) {
+            __m128 vx = _mm_mul_ps(_mm_load_ps(p->vel_x + i), drag);
+            __m128 vy = _mm_add_ps(_mm_mul_ps(_mm_load_ps(p->vel_y + i), drag), grav);
+            _mm_store_ps(p->vel_x + i, vx);
+            _mm_store_ps(p->vel_y + i, vy);
+            _mm_store_ps(p->pos_x + i, _mm_add_ps(_mm_load_ps(p->pos_x + i), vx));
+            _mm_store_ps(p->pos_y + i, _mm_add_ps(_mm_load_ps(p->pos_y + i), vy));
+        }
+        for (; i < n; i++) { // Scalar tail (< 4 slots)
+            p->vel_x[i] *= PARTICLE_DRAG;
+            p->vel_y[i] = p->vel_y[i] * PARTICLE_DRAG + PARTICLE_GRAVITY;
+            p->pos_x[i] += p->vel_x[i];
+            p->pos_y[i] += p->vel_y[i];
+        }
+    }
+#else
+    for (int i = 0; i < n; i++) {
+        p->vel_x[i] *= PARTICLE_DRAG;
+        p->vel_y[i] = p->vel_y[i] * PARTICLE_DRAG + PARTICLE_GRAVITY;
+        p->pos_x[i] += p->vel_x[i];
+        p->pos_y[i] += p->vel_y[i];
+    }
+#endif
+
+    // Pass 2: age and compact
+    for (int i = 0; i < p->live_count; ) {
+        if (--p->life[i] <= 0) {
+            // Swap-with-last keeps the live region compact; re-process slot i
+            int last = --p->live_count;
+            p->pos_x[i] = p->pos_x[last];
+            p->pos_y[i] = p->pos_y[last];
+            p->prev_x[i] = p->prev_x[last];
+            p->prev_y[i] = p->prev_y[last];
+            p->vel_x[i] = p->vel_x[last];
+            p->vel_y[i] = p->vel_y[last];
+            p->life[i]  = p->life[last];
+            p->color[i] = p->color[last];
+            p->icon[i]  = p->icon[last];
+        } else {
+            i++;
         }
     }
 }
 
-void Game_Draw() {
-    Render_Clear(COL_BLACK);
+// --- Layered scene compositor ----------------------------------------------------------
+// Game_Draw used to be one function branching on g.scene and redrawing
+// everything; it is now an ordered layer table. Dynamic layers run their
+// callback every frame; static layers render once into a cached CHAR_INFO
+// buffer and are composited from it until marked dirty.
+
+static void Layer_GameBackground(void) {
+    float alpha = Game_InterpAlpha();
+
+    // Camera follows the blended head position, clamped to the arena
+    Vec2 cam_cur = Snake_Segment(0);
+    Vec2 cam_prv = Snake_PrevSegmentOf(&g.snake, 0);
+    g.camera.x = cam_prv.x + (int)((cam_cur.x - cam_prv.x) * alpha + 0.5f) - SCREEN_WIDTH / 2;
+    g.camera.y = cam_prv.y + (int)((cam_cur.y - cam_prv.y) * alpha + 0.5f) - SCREEN_HEIGHT / 2;
+    if (g.camera.x < 0) g.camera.x = 0;
+    if (g.camera.y < 0) g.camera.y = 0;
+    if (g.camera.x > ARENA_WIDTH - SCREEN_WIDTH) g.camera.x = ARENA_WIDTH - SCREEN_WIDTH;
+    if (g.camera.y > ARENA_HEIGHT - SCREEN_HEIGHT) g.camera.y = ARENA_HEIGHT - SCREEN_HEIGHT;
+
+    // Extract the visible window from the baked background: one
+    // contiguous copy per row doubles as the frame clear
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        memcpy(r.pixel_data + Screen_Index(0, y),
+               r.background + Arena_Index(g.camera.x, g.camera.y + y),
+               sizeof(CHAR_INFO) * SCREEN_WIDTH);
+    }
+}
 
-    if (g.scene == SCENE_MENU) {
-        // Title Art
-        Render_Box(15, 5, 50, 20, COL_BLUE);
-        Render_String(32, 7, "SNAKE ENGINE", COL_CYAN | FOREGROUND_INTENSITY);
-        Render_String(32, 8, "============", COL_CYAN);
-        
-        Render_String(28, 11, "[1] Classic Mode", COL_WHITE);
-        Render_String(28, 12, "[2] Obstacle Mode", COL_WHITE);
-        Render_String(28, 14, "[H] Leaderboard", COL_YELLOW);
-        Render_String(28, 16, "[Q] Quit to Desktop", COL_RED);
-        
-        Render_String(20, 22, "Tip: Hold SHIFT to Dash (2x Points!)", COL_GRAY);
+static void Layer_MenuArt(void) {
+    // Title Art
+    Render_Box(15, 5, 50, 20, COL_BLUE);
+    Render_String(32, 7, "SNAKE ENGINE", COL_CYAN | FOREGROUND_INTENSITY);
+    Render_String(32, 8, "============", COL_CYAN);
+
+    Render_String(28, 11, "[1] Classic Mode", COL_WHITE);
+    Render_String(28, 12, "[2] Obstacle Mode", COL_WHITE);
+    Render_String(28, 13, "[3] Survival Mode (AI)", COL_WHITE);
+    Render_String(28, 14, "[4] Speedrun Mode", COL_WHITE);
+    Render_String(28, 16, "[H] Leaderboard", COL_YELLOW);
+    Render_String(28, 18, "[Q] Quit to Desktop", COL_RED);
+
+    Render_String(20, 22, "Tip: Hold SHIFT to Dash (2x Points!)", COL_GRAY);
+}
+
+static void Layer_GameOverFrame(void) {
+    Render_Box(25, 10, 30, 10, COL_RED);
+    Render_String(35, 12, "GAME OVER", COL_RED | FOREGROUND_INTENSITY);
+}
+
+static void Layer_GameOverInfo(void) {
+    if (g.mode == MODE_VERSUS) {
+        if (net.local_won)
+            Render_String(33, 13, "YOU WIN!", COL_GREEN | FOREGROUND_INTENSITY);
+        else
+            Render_String(32, 13, "PEER WINS", COL_RED);
     }
-    else if (g.scene == SCENE_GAMEOVER) {
-        Render_Box(25, 10, 30, 10, COL_RED);
-        Render_String(35, 12, "GAME OVER", COL_RED | FOREGROUND_INTENSITY);
-        
-        char buf[32];
-        sprintf(buf, "Final Score: %d", g.score);
-        Render_String(32, 14, buf, COL_WHITE);
-        
-        Render_String(27, 16, "Name: ", COL_YELLOW);
-        Render_String(33, 16, g.player_name, COL_WHITE | FOREGROUND_INTENSITY);
-        // Blinking cursor
-        if ((clock() / 250) % 2 == 0) Render_Char(33 + g.name_cursor, 16, '_', COL_WHITE);
-    }
-    else if (g.scene == SCENE_SCORES) {
-        Render_Box(20, 5, 40, 20, COL_YELLOW);
-        Render_String(35, 7, "LEADERBOARD", COL_YELLOW | FOREGROUND_INTENSITY);
-        
-        Render_String(25, 9, "Name          Score", COL_GRAY);
-        Render_String(25, 10, "--------------------", COL_GRAY);
-        
-        for(int i=0; i<MAX_SCORES; i++) {
-            if (leaderboard[i].score > 0) {
-                char buf[64];
-                sprintf(buf, "%-12s  %6d", leaderboard[i].name, leaderboard[i].score);
-                Render_String(25, 12 + i, buf, COL_WHITE);
+
+    if (Hud_Begin(&hud.gameover, g.score, scores.version, 0, 0)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+        n += Fmt_Str(buf + n, "Final Score: ");
+        n += Fmt_Int(buf + n, g.score);
+        n += Fmt_Str(buf + n, " (rank #");
+        n += Fmt_Int(buf + n, Score_RankOf(g.score));
+        n += Fmt_Str(buf + n, ")");
+        buf[n] = '\0';
+        Hud_Commit(&hud.gameover, buf, COL_WHITE);
+    }
+    Hud_Blit(&hud.gameover, 29, 14);
+
+    // Speedrun result: the tick-derived final time
+    if (g.mode == MODE_SPEEDRUN) {
+        if (Hud_Begin(&hud.sr_final, (int)(g.run_time_us / 1000), 0, 0, 0)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+            n += Fmt_Str(buf + n, "Time: ");
+            n += Fmt_TimeUs(buf + n, g.run_time_us);
+            buf[n] = '\0';
+            Hud_Commit(&hud.sr_final, buf, COL_CYAN | FOREGROUND_INTENSITY);
+        }
+        Hud_Blit(&hud.sr_final, 32, 15);
+    }
+
+    Render_String(27, 16, "Name: ", COL_YELLOW);
+    Render_String(33, 16, g.player_name, COL_WHITE | FOREGROUND_INTENSITY);
+    // Blinking cursor
+    if ((clock() / 250) % 2 == 0) Render_Char(33 + g.name_cursor, 16, '_', COL_WHITE);
+}
+
+static void Layer_ScoresFrame(void) {
+    Render_Box(20, 5, 40, 20, COL_YELLOW);
+    Render_String(35, 7, "LEADERBOARD", COL_YELLOW | FOREGROUND_INTENSITY);
+
+    Render_String(25, 9, "  #  Name          Score", COL_GRAY);
+    Render_String(25, 10, "-------------------------", COL_GRAY);
+    Render_String(25, 22, "[ESC] Return", COL_WHITE);
+}
+
+static void Layer_ScoresRows(void) {
+    // Ranked queries against the index — never a full-dataset scan.
+    // Rows rebuild only when the index version moves.
+    for(int i=0; i<MAX_SCORES; i++) {
+        const ScoreEntry* e = Score_Top(i);
+        if (e && e->score > 0) {
+            if (Hud_Begin(&hud.board[i], scores.version, i, 0, 0)) {
+                char buf[SCREEN_WIDTH]; int n = 0;
+                n += Fmt_IntPad(buf + n, i + 1, 3);
+                n += Fmt_Str(buf + n, "  ");
+                n += Fmt_StrPad(buf + n, e->name, 12);
+                n += Fmt_Str(buf + n, " ");
+                n += Fmt_IntPad(buf + n, e->score, 6);
+                buf[n] = '\0';
+                Hud_Commit(&hud.board[i], buf, COL_WHITE);
+            }
+            Hud_Blit(&hud.board[i], 25, 12 + i);
+        }
+    }
+
+    // This player's best and where it sits among all stored runs
+    if (g.player_name[0]) {
+        const ScoreEntry* best = Score_BestOf(g.player_name);
+        if (best) {
+            int name_key = 0;
+            for (const char* c = g.player_name; *c; c++) name_key = name_key * 31 + *c;
+            if (Hud_Begin(&hud.board_best, scores.version, name_key, 0, 0)) {
+                char buf[SCREEN_WIDTH]; int n = 0;
+                n += Fmt_Str(buf + n, best->name);
+                n += Fmt_Str(buf + n, " best: ");
+                n += Fmt_Int(buf + n, best->score);
+                n += Fmt_Str(buf + n, " (rank ");
+                n += Fmt_Int(buf + n, Score_RankOf(best->score));
+                n += Fmt_Str(buf + n, " of ");
+                n += Fmt_Int(buf + n, scores.count);
+                n += Fmt_Str(buf + n, ")");
+                buf[n] = '\0';
+                Hud_Commit(&hud.board_best, buf, COL_CYAN);
             }
+            Hud_Blit(&hud.board_best, 25, 23);
         }
-        Render_String(25, 22, "[ESC] Return", COL_WHITE);
     }
-    else if (g.scene == SCENE_GAME) {
-        // 1. Draw Map
-        for(int y=0; y<SCREEN_HEIGHT; y++) {
-            for(int x=0; x<SCREEN_WIDTH; x++) {
-                if(g.map[x][y]) Render_Char(x, y, 0x2588, COL_GRAY);
+}
+
+// Draw one snake with run batching. Only the head and tail actually move
+// within a tick, so they keep the blended sub-cell rendering; interior
+// segments sit still on their current cells and are coalesced into
+// straight horizontal/vertical runs, each emitted as one span fill. The
+// attribute branching (theme/head/dash) is resolved once per snake, not
+// re-evaluated per segment.
+static void Snake_DrawRuns(Snake* s, WORD head_attr, WORD body_attr) {
+    float alpha = Game_InterpAlpha();
+
+    // Head: sub-cell half-block glyph, blended
+    Vec2 cur = Snake_SegmentOf(s, 0);
+    Vec2 prv = Snake_PrevSegmentOf(s, 0);
+    float fx = prv.x + (cur.x - prv.x) * alpha;
+    float fy = prv.y + (cur.y - prv.y) * alpha;
+    int cx, cy;
+    wchar_t glyph = Interp_Glyph(fx, fy, &cx, &cy);
+    Render_Char(cx - g.camera.x, cy - g.camera.y, glyph, head_attr);
+
+    // Interior: segments 1..length-2, batched into collinear runs
+    int last = s->length - 2;
+    int i = 1;
+    while (i <= last) {
+        Vec2 a = Snake_SegmentOf(s, i);
+        int dx = 0, dy = 0, n = 1;
+        if (i < last) {
+            Vec2 b = Snake_SegmentOf(s, i + 1);
+            dx = b.x - a.x;
+            dy = b.y - a.y;
+            if ((dx == 0) != (dy == 0)) { // Straight neighbor: extend the run
+                Vec2 p = b;
+                n = 2;
+                while (i + n <= last) {
+                    Vec2 q = Snake_SegmentOf(s, i + n);
+                    if (q.x - p.x != dx || q.y - p.y != dy) break;
+                    p = q;
+                    n++;
+                }
+            }
+        }
+
+        if (n == 1) {
+            Render_Char(a.x - g.camera.x, a.y - g.camera.y, 0x2592, body_attr);
+        } else if (dy == 0) {
+            int x0 = (dx > 0) ? a.x : a.x + dx * (n - 1);
+            Render_Fill(x0 - g.camera.x, a.y - g.camera.y, n, 0x2592, body_attr);
+        } else {
+            int y0 = (dy > 0) ? a.y : a.y + dy * (n - 1);
+            Render_FillCol(a.x - g.camera.x, y0 - g.camera.y, n, 0x2592, body_attr);
+        }
+        i += n;
+    }
+
+    // Tail: the cell being vacated this tick, blended like the head but
+    // keeping the body glyph (snaps at half-cell granularity as before)
+    if (s->length > 1) {
+        int t = s->length - 1;
+        cur = Snake_SegmentOf(s, t);
+        prv = Snake_PrevSegmentOf(s, t);
+        fx = prv.x + (cur.x - prv.x) * alpha;
+        fy = prv.y + (cur.y - prv.y) * alpha;
+        Interp_Glyph(fx, fy, &cx, &cy);
+        Render_Char(cx - g.camera.x, cy - g.camera.y, 0x2592, body_attr);
+    }
+}
+
+static void Layer_GameEntities(void) {
+    // Entities live in arena coordinates; subtract the camera to get
+    // screen cells — the Render_* calls clip anything outside the window.
+
+    // Food
+    Render_Char(g.food.x - g.camera.x, g.food.y - g.camera.y, 0x2666, COL_RED | FOREGROUND_INTENSITY);
+
+    // Player snake
+    WORD body_attr = g.snake.color_theme;
+    WORD head_attr = g.snake.color_theme | FOREGROUND_INTENSITY;
+    if (g.is_dashing) head_attr = body_attr = COL_RED | FOREGROUND_INTENSITY; // Turn red when dashing
+    Snake_DrawRuns(&g.snake, head_attr, body_attr);
+
+    // AI opponents (same batching and blending)
+    for(int a=0; a<g.ai_count; a++) {
+        if (!g.ai[a].alive) continue;
+        Snake* s = &g.ai[a].snake;
+        Snake_DrawRuns(s, s->color_theme | FOREGROUND_INTENSITY, s->color_theme);
+    }
+}
+
+static void Layer_GameParticles(void) {
+    float alpha = Game_InterpAlpha();
+
+    // Only the live region; blended sub-cell positions quantize to their
+    // containing cell only here
+    for(int i=0; i<g.particles.live_count; i++) {
+        float fx = g.particles.prev_x[i] + (g.particles.pos_x[i] - g.particles.prev_x[i]) * alpha;
+        float fy = g.particles.prev_y[i] + (g.particles.pos_y[i] - g.particles.prev_y[i]) * alpha;
+        Render_Char((int)fx - g.camera.x, (int)fy - g.camera.y,
+            g.particles.icon[i], g.particles.color[i]);
+    }
+}
+
+static void Layer_GameHud(void) {
+    // Cached lines, reformatted only on change
+    if (Hud_Begin(&hud.status, g.score, g.combo_multiplier, g.is_dashing, 0)) {
+        char buf[SCREEN_WIDTH]; int n = 0;
+        n += Fmt_Str(buf + n, " SCORE: ");
+        n += Fmt_Int(buf + n, g.score);
+        n += Fmt_Str(buf + n, " | COMBO: x");
+        n += Fmt_Int(buf + n, g.combo_multiplier);
+        n += Fmt_Str(buf + n, " | DASH: ");
+        n += Fmt_Str(buf + n, g.is_dashing ? "ON " : "OFF ");
+        buf[n] = '\0';
+        Hud_Commit(&hud.status, buf, COL_BLACK | (COL_WHITE << 4));
+    }
+    Hud_Blit(&hud.status, 2, 0);
+
+    // Combo Bar visual
+    if (g.combo_multiplier > 1) {
+        Render_Fill(2, 1, g.combo_timer / 2, 0x2580, COL_YELLOW);
+    }
+
+    // Speedrun clock and splits, top right (simulated time)
+    if (g.mode == MODE_SPEEDRUN) {
+        if (Hud_Begin(&hud.sr_timer, (int)(g.run_time_us / 1000), 0, 0, 0)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+            n += Fmt_Str(buf + n, "TIME ");
+            n += Fmt_TimeUs(buf + n, g.run_time_us);
+            buf[n] = '\0';
+            Hud_Commit(&hud.sr_timer, buf, COL_WHITE | FOREGROUND_INTENSITY);
+        }
+        Hud_Blit(&hud.sr_timer, SCREEN_WIDTH - 16, 0);
+
+        for (int s = 0; s < g.splits_taken; s++) {
+            if (Hud_Begin(&hud.sr_split[s], (int)(g.split_us[s] / 1000), s, 0, 0)) {
+                char buf[SCREEN_WIDTH]; int n = 0;
+                n += Fmt_IntPad(buf + n, speedrun_milestones[s], 3);
+                n += Fmt_Str(buf + n, "  ");
+                n += Fmt_TimeUs(buf + n, g.split_us[s]);
+                buf[n] = '\0';
+                Hud_Commit(&hud.sr_split[s], buf, COL_CYAN);
+            }
+            Hud_Blit(&hud.sr_split[s], SCREEN_WIDTH - 16, 1 + s);
+        }
+    }
+}
+
+static void Layer_GameOverlay(void) {
+    // Start Prompt
+    if (!g.has_started) {
+        Render_String(SCREEN_WIDTH/2 - 12, SCREEN_HEIGHT/2 - 5, "PRESS ARROWS TO START", COL_WHITE | FOREGROUND_INTENSITY);
+    }
+
+    // Debug Overlay
+    if (g.debug_mode) {
+        Vec2 dbg_head = Snake_Segment(0);
+        if (Hud_Begin(&hud.dbg_fps, (int)g.fps, dbg_head.x, dbg_head.y, 0)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+            n += Fmt_Str(buf + n, "FPS: ");
+            n += Fmt_Int(buf + n, (int)g.fps);
+            n += Fmt_Str(buf + n, " | X:");
+            n += Fmt_Int(buf + n, dbg_head.x);
+            n += Fmt_Str(buf + n, " Y:");
+            n += Fmt_Int(buf + n, dbg_head.y);
+            buf[n] = '\0';
+            Hud_Commit(&hud.dbg_fps, buf, COL_GREEN);
+        }
+        Hud_Blit(&hud.dbg_fps, SCREEN_WIDTH - 25, 0);
+
+        // Per-phase timings from the last frame, keyed at centi-ms
+        // granularity so a steady frame costs no reformat
+        if (Hud_Begin(&hud.dbg_phase, (int)(prof.input_ms * 100), (int)(prof.update_ms * 100),
+                      (int)(prof.draw_ms * 100), prof.present_us / 10)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+            n += Fmt_Str(buf + n, "in");
+            n += Fmt_Fixed2(buf + n, prof.input_ms, 5);
+            n += Fmt_Str(buf + n, " up");
+            n += Fmt_Fixed2(buf + n, prof.update_ms, 5);
+            n += Fmt_Str(buf + n, " dr");
+            n += Fmt_Fixed2(buf + n, prof.draw_ms, 5);
+            n += Fmt_Str(buf + n, " pr");
+            n += Fmt_Fixed2(buf + n, prof.present_us / 1000.0, 5);
+            n += Fmt_Str(buf + n, " ms");
+            buf[n] = '\0';
+            Hud_Commit(&hud.dbg_phase, buf, COL_GREEN);
+        }
+        Hud_Blit(&hud.dbg_phase, SCREEN_WIDTH - 35, 1);
+
+        // Frame-time sparkline, newest on the right; taller = slower
+        float peak = 1.0f;
+        for (int k = 0; k < PROFILE_HISTORY; k++)
+            if (prof.history[k] > peak) peak = prof.history[k];
+        for (int k = 0; k < PROFILE_HISTORY; k++) {
+            float v = prof.history[(prof.history_head + k) % PROFILE_HISTORY];
+            int level = (int)(v / peak * 7.0f);
+            if (level > 7) level = 7;
+            Render_Char(SCREEN_WIDTH - 3 - PROFILE_HISTORY + k, 2,
+                (wchar_t)(0x2581 + level), COL_GREEN);
+        }
+
+        if (Hud_Begin(&hud.dbg_trace, prof.trace_count, 0, 0, 0)) {
+            char buf[SCREEN_WIDTH]; int n = 0;
+            n += Fmt_Str(buf + n, "F4: dump trace (");
+            n += Fmt_Int(buf + n, prof.trace_count);
+            n += Fmt_Str(buf + n, " frames)");
+            buf[n] = '\0';
+            Hud_Commit(&hud.dbg_trace, buf, COL_GRAY);
+        }
+        Hud_Blit(&hud.dbg_trace, SCREEN_WIDTH - 28, 3);
+    }
+}
+
+// The compositor itself. Order within a scene is paint order; static
+// layers render into their cache once and are block-copied while clean.
+typedef struct {
+    SceneState scene;
+    void (*draw)(void);
+    bool is_static;     // Composited from `cache` until marked dirty
+    bool dirty;
+    CHAR_INFO* cache;   // Full-screen snapshot, allocated on first refresh
+} DrawLayer;
+
+static DrawLayer draw_layers[] = {
+    { SCENE_MENU,     Layer_MenuArt,        true,  true, NULL },
+    { SCENE_GAME,     Layer_GameBackground, false, true, NULL },
+    { SCENE_GAME,     Layer_GameEntities,   false, true, NULL },
+    { SCENE_GAME,     Layer_GameParticles,  false, true, NULL },
+    { SCENE_GAME,     Layer_GameHud,        false, true, NULL },
+    { SCENE_GAME,     Layer_GameOverlay,    false, true, NULL },
+    { SCENE_GAMEOVER, Layer_GameOverFrame,  true,  true, NULL },
+    { SCENE_GAMEOVER, Layer_GameOverInfo,   false, true, NULL },
+    { SCENE_SCORES,   Layer_ScoresFrame,    true,  true, NULL },
+    { SCENE_SCORES,   Layer_ScoresRows,     false, true, NULL },
+};
+
+// Re-render a static layer into its cache. The callback paints through
+// the normal Render_* calls; pointing r.pixel_data at the cache for the
+// duration captures its output without a separate draw path.
+static void Layer_Refresh(DrawLayer* l) {
+    if (!l->cache)
+        l->cache = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    if (!l->cache) return; // Degrade: the layer just draws every frame
+
+    CHAR_INFO* saved = r.pixel_data;
+    r.pixel_data = l->cache;
+    Render_Clear(COL_BLACK); // Static layers are the base of their scene
+    l->draw();
+    r.pixel_data = saved;
+    l->dirty = false;
+}
+
+void Game_Draw() {
+    for (int i = 0; i < (int)(sizeof(draw_layers) / sizeof(draw_layers[0])); i++) {
+        DrawLayer* l = &draw_layers[i];
+        if (l->scene != g.scene) continue;
+
+        if (l->is_static) {
+            if (l->dirty || !l->cache) Layer_Refresh(l);
+            if (l->cache) {
+                memcpy(r.pixel_data, l->cache, sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+                continue;
+            }
+            // Cache allocation failed: fall through and draw live
+            Render_Clear(COL_BLACK);
+        }
+        l->draw();
+    }
+}
+
+// ======================================================================================
+// PROFILING & TRACE
+// ======================================================================================
+
+void Profiler_Record(double frame_ms) {
+    prof.history[prof.history_head] = (float)frame_ms;
+    prof.history_head = (prof.history_head + 1) % PROFILE_HISTORY;
+
+    FrameRecord* rec = &prof.trace[prof.trace_head];
+    rec->frame_ms   = (float)frame_ms;
+    rec->input_ms   = (float)prof.input_ms;
+    rec->update_ms  = (float)prof.update_ms;
+    rec->draw_ms    = (float)prof.draw_ms;
+    rec->present_ms = prof.present_us / 1000.0f;
+    prof.trace_head = (prof.trace_head + 1) % TRACE_CAPACITY;
+    if (prof.trace_count < TRACE_CAPACITY) prof.trace_count++;
+}
+
+void Profiler_DumpTrace() {
+    FILE* f = fopen(TRACE_FILE, "wb");
+    if (!f) return;
+
+    // Small header so offline tooling can sanity-check the dump
+    unsigned int magic = 0x534E4B54; // 'SNKT'
+    unsigned int version = 1;
+    unsigned int count = (unsigned int)prof.trace_count;
+    fwrite(&magic, sizeof(magic), 1, f);
+    fwrite(&version, sizeof(version), 1, f);
+    fwrite(&count, sizeof(count), 1, f);
+
+    // Oldest record first
+    int start = (prof.trace_count == TRACE_CAPACITY) ? prof.trace_head : 0;
+    for (int i = 0; i < prof.trace_count; i++) {
+        fwrite(&prof.trace[(start + i) % TRACE_CAPACITY], sizeof(FrameRecord), 1, f);
+    }
+    fclose(f);
+}
+
+// ======================================================================================
+// REPLAY SYSTEM
+// ======================================================================================
+
+void Replay_RecordEvent(unsigned char code) {
+    if (!replay.recording || replay.playing) return;
+
+    unsigned int delta = g.tick_count - replay.last_event_tick;
+    while (delta > 0xFFFF && replay.count < REPLAY_MAX_EVENTS) {
+        replay.events[replay.count++] = (ReplayEvent){ 0xFFFF, REPLAY_EV_PAD };
+        delta -= 0xFFFF;
+    }
+    if (replay.count >= REPLAY_MAX_EVENTS) {
+        replay.recording = false; // Buffer full — keep what we have
+        return;
+    }
+    replay.events[replay.count++] = (ReplayEvent){ (unsigned short)delta, code };
+    replay.last_event_tick = g.tick_count;
+}
+
+void Replay_Save() {
+    FILE* f = fopen(REPLAY_FILE, "wb");
+    if (!f) return;
+
+    unsigned int magic = REPLAY_MAGIC;
+    unsigned int version = REPLAY_VERSION;
+    fwrite(&magic, sizeof(magic), 1, f);
+    fwrite(&version, sizeof(version), 1, f);
+    fwrite(&replay.seed, sizeof(replay.seed), 1, f);
+    fwrite(&replay.mode, sizeof(replay.mode), 1, f);
+    fwrite(&replay.count, sizeof(replay.count), 1, f);
+    fwrite(replay.events, sizeof(ReplayEvent), replay.count, f);
+    fclose(f);
+}
+
+void Replay_Play(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) { printf("replay: cannot open %s\n", path); return; }
+
+    unsigned int magic = 0, version = 0;
+    fread(&magic, sizeof(magic), 1, f);
+    fread(&version, sizeof(version), 1, f);
+    if (magic != REPLAY_MAGIC || version != REPLAY_VERSION) {
+        printf("replay: %s is not a v%d replay file\n", path, REPLAY_VERSION);
+        fclose(f);
+        return;
+    }
+    fread(&replay.seed, sizeof(replay.seed), 1, f);
+    fread(&replay.mode, sizeof(replay.mode), 1, f);
+    fread(&replay.count, sizeof(replay.count), 1, f);
+    // count is signed on disk: a negative value from a truncated file
+    // would turn into a huge size_t below, so range-check both ends
+    if (replay.count < 0 || replay.count > REPLAY_MAX_EVENTS) {
+        printf("replay: %s has a corrupt event count\n", path);
+        fclose(f);
+        return;
+    }
+    fread(replay.events, sizeof(ReplayEvent), replay.count, f);
+    fclose(f);
+
+    // Headless boot through the shared bench path — Level_Generate bakes
+    // into r.background, so the frame buffers must exist even though the
+    // re-simulation never presents. Runs at full speed, no tick pacing.
+    Bench_BootHeadless();
+    replay.playing = true; // Seed and mode were just loaded from the file
+    g.mode = (GameMode)replay.mode;
+    Game_Reset();
+    g.has_started = true;
+
+    // Absolute tick of the next pending event
+    int next_ev = 0;
+    unsigned int next_ev_tick = (replay.count > 0) ? replay.events[0].tick_delta : 0;
+    unsigned int last_ev_tick = next_ev_tick;
+    for (int i = 1; i < replay.count; i++) last_ev_tick += replay.events[i].tick_delta;
+    unsigned int tick_limit = last_ev_tick + 100000; // Safety stop if the run never dies
+
+    LARGE_INTEGER t0, t1;
+    QueryPerformanceCounter(&t0);
+
+    while (g.scene == SCENE_GAME && g.tick_count < tick_limit) {
+        // Feed back every input change stamped for this tick
+        while (next_ev < replay.count && next_ev_tick <= g.tick_count) {
+            switch (replay.events[next_ev].code) {
+                case REPLAY_EV_UP:       Input_Enqueue((Vec2){0, -1}); break;
+                case REPLAY_EV_DOWN:     Input_Enqueue((Vec2){0, 1});  break;
+                case REPLAY_EV_LEFT:     Input_Enqueue((Vec2){-1, 0}); break;
+                case REPLAY_EV_RIGHT:    Input_Enqueue((Vec2){1, 0});  break;
+                case REPLAY_EV_DASH_ON:  g.is_dashing = true;  break;
+                case REPLAY_EV_DASH_OFF: g.is_dashing = false; break;
+                default: break; // REPLAY_EV_PAD
             }
+            next_ev++;
+            if (next_ev < replay.count) next_ev_tick += replay.events[next_ev].tick_delta;
         }
 
-        // 2. Draw Food
-        Render_Char(g.food.x, g.food.y, 0x2666, COL_RED | FOREGROUND_INTENSITY);
+        Arena_Reset(&arena_frame); // Stands in for the per-frame reset
+        Game_UpdateFixed();
+        Particles_Update();
+    }
+
+    QueryPerformanceCounter(&t1);
+    double elapsed = (double)(t1.QuadPart - t0.QuadPart) / perf_freq.QuadPart;
+
+    printf("Replay: %u ticks re-simulated in %.3fs (%.0f ticks/sec)\n",
+        g.tick_count, elapsed, g.tick_count / (elapsed > 0 ? elapsed : 1e-9));
+    printf("  outcome: %s | score: %d | length: %d | events: %d\n",
+        (g.scene == SCENE_GAMEOVER) ? "death" : "alive at input end",
+        g.score, g.snake.length, replay.count);
+
+    Bench_FreeHeadless();
+}
+
+// ======================================================================================
+// NETPLAY
+// ======================================================================================
+
+// Open the UDP socket; shared by both handshake paths
+static bool Net_Open() {
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+    net.sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (net.sock == INVALID_SOCKET) { WSACleanup(); return false; }
+
+    // Handshake recvs block with a timeout; the socket goes non-blocking
+    // once the session is live
+    DWORD timeout = NET_HANDSHAKE_MS;
+    setsockopt(net.sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&timeout, sizeof(timeout));
+    return true;
+}
+
+static void Net_GoLive() {
+    unsigned long nonblock = 1;
+    ioctlsocket(net.sock, FIONBIO, &nonblock);
+    net.active = true;
+    replay.recording = false; // A half-session replay cannot re-simulate
+}
+
+static void Net_SendPacket(const NetPacket* pkt) {
+    sendto(net.sock, (const char*)pkt, sizeof(*pkt), 0,
+           (const struct sockaddr*)&net.peer, sizeof(net.peer));
+}
+
+bool Net_Host() {
+    if (!Net_Open()) return false;
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(NET_PORT);
+    local.sin_addr.s_addr = INADDR_ANY;
+    if (bind(net.sock, (struct sockaddr*)&local, sizeof(local)) == SOCKET_ERROR) {
+        closesocket(net.sock);
+        WSACleanup();
+        return false;
+    }
+
+    printf("Hosting versus match on UDP %d, waiting for a peer...\n", NET_PORT);
+
+    NetPacket pkt;
+    int peer_len = sizeof(net.peer);
+    for (;;) {
+        int len = recvfrom(net.sock, (char*)&pkt, sizeof(pkt), 0,
+                           (struct sockaddr*)&net.peer, &peer_len);
+        if (len <= 0) { closesocket(net.sock); WSACleanup(); return false; } // Timed out
+        if (len >= (int)sizeof(pkt) && pkt.magic == NET_MAGIC && pkt.type == NET_PKT_HELLO) break;
+    }
+
+    // The host draws the shared seed and hands it to the peer
+    LARGE_INTEGER entropy;
+    QueryPerformanceCounter(&entropy);
+    replay.seed = (unsigned int)time(NULL) ^ (unsigned int)entropy.QuadPart;
+
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.magic = NET_MAGIC;
+    pkt.type = NET_PKT_START;
+    pkt.seed = replay.seed;
+    Net_SendPacket(&pkt);
+
+    net.host = true;
+    Net_GoLive();
+    return true;
+}
 
-        // 3. Draw Snake
-        for(int i=0; i<g.snake.length; i++) {
-            WORD c = g.snake.color_theme;
-            if (g.is_dashing) c = COL_RED | FOREGROUND_INTENSITY; // Turn red when dashing
-            else if (i == 0) c |= FOREGROUND_INTENSITY; // Bright head
-            
-            Render_Char(g.snake.body[i].x, g.snake.body[i].y, (i==0)?0x2588:0x2592, c);
+bool Net_Join(const char* ip) {
+    if (!Net_Open()) return false;
+
+    memset(&net.peer, 0, sizeof(net.peer));
+    net.peer.sin_family = AF_INET;
+    net.peer.sin_port = htons(NET_PORT);
+    net.peer.sin_addr.s_addr = inet_addr(ip);
+
+    printf("Joining versus match at %s:%d...\n", ip, NET_PORT);
+
+    NetPacket pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.magic = NET_MAGIC;
+    pkt.type = NET_PKT_HELLO;
+    Net_SendPacket(&pkt);
+
+    for (;;) {
+        int len = recvfrom(net.sock, (char*)&pkt, sizeof(pkt), 0, NULL, NULL);
+        if (len <= 0) { closesocket(net.sock); WSACleanup(); return false; }
+        if (len >= (int)sizeof(pkt) && pkt.magic == NET_MAGIC && pkt.type == NET_PKT_START) break;
+    }
+
+    replay.seed = pkt.seed;
+    net.host = false;
+    Net_GoLive();
+    return true;
+}
+
+// Stamp a local direction change for a near-future tick and log it. The
+// one-tick delay matches the offline input queue's next-boundary latency,
+// and gives the packet a LAN round trip of headroom to beat the boundary.
+void Net_QueueLocal(unsigned char code) {
+    NetEvent ev = { g.tick_count + NET_INPUT_DELAY, code };
+    net.local_log[net.local_count & (NET_LOG_SIZE - 1)] = ev;
+    net.local_count++;
+}
+
+// Execute every event in a log that is due this tick. Both machines run
+// this against identical snake state, so the 180 filter agrees too.
+void Net_ApplyEvents(NetEvent* log, int count, int* applied, Snake* s) {
+    static const Vec2 dirs[4] = { {0,-1}, {0,1}, {-1,0}, {1,0} }; // UP DOWN LEFT RIGHT
+    while (*applied < count) {
+        NetEvent* ev = &log[*applied & (NET_LOG_SIZE - 1)];
+        if (ev->tick > g.tick_count) break;
+        Vec2 d = dirs[ev->code & 3];
+        if (!(s->length > 1 && d.x == -s->dir.x && d.y == -s->dir.y)) s->dir = d;
+        (*applied)++;
+    }
+}
+
+// Drain the socket, merge peer events by sequence number, and send our
+// trailing window. Runs once per frame whether or not a tick executes.
+void Net_Pump() {
+    NetPacket pkt;
+    for (;;) {
+        int len = recvfrom(net.sock, (char*)&pkt, sizeof(pkt), 0, NULL, NULL);
+        if (len < (int)sizeof(pkt)) break; // Empty (WSAEWOULDBLOCK) or runt
+        if (pkt.magic != NET_MAGIC) continue;
+
+        if (pkt.type == NET_PKT_BYE) {
+            // Peer left mid-match: score it as a win and end the round
+            net.active = false;
+            closesocket(net.sock);
+            WSACleanup();
+            net.local_won = true;
+            g.scene = SCENE_GAMEOVER;
+            g.name_cursor = 0;
+            memset(g.player_name, 0, 16);
+            return;
+        }
+        if (pkt.type != NET_PKT_INPUT) continue;
+
+        if (pkt.tick > net.remote_tick) net.remote_tick = pkt.tick;
+        if (pkt.ack > net.local_acked) net.local_acked = pkt.ack;
+
+        // Events are merged strictly in sequence order; duplicates from
+        // the redundancy window fall out, gaps wait for the next resend
+        for (int i = 0; i < pkt.count && i < NET_WINDOW; i++) {
+            unsigned int seq = pkt.first_seq + i;
+            if (seq != (unsigned int)net.remote_count) continue;
+            net.remote_log[net.remote_count & (NET_LOG_SIZE - 1)] = pkt.ev[i];
+            net.remote_count++;
         }
+    }
+
+    // Outbound: watermark, ack, and the oldest NET_WINDOW events the peer
+    // has not confirmed. Resending from the ack (not the log tail) means a
+    // loss burst longer than the window still heals: the gap is always the
+    // next thing retransmitted, and the ack advances as it fills.
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.magic = NET_MAGIC;
+    pkt.type = NET_PKT_INPUT;
+    pkt.tick = g.tick_count;
+    pkt.ack = (unsigned int)net.remote_count;
+    int backlog = net.local_count - (int)net.local_acked;
+    int n = (backlog < NET_WINDOW) ? backlog : NET_WINDOW;
+    pkt.first_seq = net.local_acked;
+    pkt.count = (unsigned char)n;
+    for (int i = 0; i < n; i++)
+        pkt.ev[i] = net.local_log[(pkt.first_seq + i) & (NET_LOG_SIZE - 1)];
+    Net_SendPacket(&pkt);
+}
+
+// The peer's watermark says "every event for ticks before tick+delay has
+// been sent"; simulating past it would race inputs still on the wire.
+bool Net_CanStep() {
+    return g.tick_count < net.remote_tick + NET_INPUT_DELAY;
+}
+
+// Simulate the peer's snake for this tick: the exact shared-world sequence
+// the local player runs (move through the occupancy grid, eat, grow), so
+// both machines compute identical state for it.
+void Net_StepRemote() {
+    AiAgent* a = &g.ai[0];
+    Snake* s = &a->snake;
+    if (!a->alive) return;
+
+    Net_ApplyEvents(net.remote_log, net.remote_count, &net.remote_applied, s);
+
+    Vec2 head = Snake_SegmentOf(s, 0);
+    Vec2 next = { head.x + s->dir.x, head.y + s->dir.y };
+    Vec2 tail = Snake_SegmentOf(s, s->length - 1);
 
-        // 4. Draw Particles
-        for(int i=0; i<MAX_PARTICLES; i++) {
-            if (g.particles[i].life > 0) {
-                Render_Char(g.particles[i].pos.x, g.particles[i].pos.y, g.particles[i].icon, g.particles[i].color);
+    bool dead = false;
+    if (next.x < 0 || next.x >= ARENA_WIDTH || next.y < 0 || next.y >= ARENA_HEIGHT) dead = true;
+    else if (Grid_IsBlocked(next.x, next.y)) {
+        if (next.x != tail.x || next.y != tail.y) dead = true;
+    }
+
+    if (dead) {
+        a->alive = false;
+        net.local_won = true;
+        g.scene = SCENE_GAMEOVER;
+        g.name_cursor = 0;
+        memset(g.player_name, 0, 16);
+        Net_Shutdown(); // Round resolved — same teardown as a local death
+        return;
+    }
+
+    Grid_Free(tail.x, tail.y);
+    s->head = (s->head - 1) & s->cap_mask;
+    s->body[s->head] = next;
+    Grid_Occupy(next.x, next.y);
+
+    if (next.x == g.food.x && next.y == g.food.y) {
+        s->grow_pending++;
+        Particles_Spawn(next.x, next.y, 10, s->color_theme);
+        Grid_RandomFreeCell(&g.food);
+    }
+
+    if (s->grow_pending > 0 && s->length <= s->cap_mask) {
+        s->length++;
+        s->grow_pending--;
+        Vec2 new_tail = Snake_SegmentOf(s, s->length - 1);
+        Grid_Occupy(new_tail.x, new_tail.y);
+    }
+}
+
+void Net_Shutdown() {
+    if (!net.active) return;
+
+    NetPacket pkt;
+    memset(&pkt, 0, sizeof(pkt));
+    pkt.magic = NET_MAGIC;
+    pkt.type = NET_PKT_BYE;
+    Net_SendPacket(&pkt);
+
+    net.active = false;
+    closesocket(net.sock);
+    WSACleanup();
+}
+
+// --- Spectator broadcast --------------------------------------------------------------
+
+// Send exactly len bytes; TCP may take several calls. A timeout or error
+// means the viewer is gone (or wedged) — the caller drops it.
+static bool Cast_SendAll(SOCKET s, const char* src, int len) {
+    while (len > 0) {
+        int sent = send(s, src, len, 0);
+        if (sent <= 0) return false;
+        src += sent;
+        len -= sent;
+    }
+    return true;
+}
+
+// Drain the input thread's raw key ring into the held-state table and
+// report whether ESC is down. The viewer never runs Input_Process (the
+// menu/game key semantics don't apply to a spectator), so this is the
+// only consumer of the ring in that process.
+static bool Cast_ViewerQuitKey() {
+    while (in.ev_head != in.ev_tail) {
+        KeyEvent ev = in.events[in.ev_head];
+        MemoryBarrier();
+        in.ev_head = (in.ev_head + 1) % KEY_EVENT_QUEUE_SIZE;
+        in.key_down[ev.vk & 0xFF] = ev.down;
+    }
+    return in.key_down[VK_ESCAPE];
+}
+
+static bool Cast_RecvAll(SOCKET s, char* dst, int len) {
+    while (len > 0) {
+        int got = recv(s, dst, len, 0);
+        if (got < 0 && WSAGetLastError() == WSAETIMEDOUT) {
+            // Idle feed (the caster skips empty deltas, so a parked menu
+            // sends nothing): poll the quit key, then resume the partial
+            // read exactly where it stopped
+            if (Cast_ViewerQuitKey()) return false;
+            continue;
+        }
+        if (got <= 0) return false;
+        dst += got;
+        len -= got;
+    }
+    return true;
+}
+
+bool Cast_Start() {
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+
+    cast.listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (cast.listen_sock == INVALID_SOCKET) { WSACleanup(); return false; }
+
+    struct sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(CAST_PORT);
+    local.sin_addr.s_addr = INADDR_ANY;
+    if (bind(cast.listen_sock, (struct sockaddr*)&local, sizeof(local)) == SOCKET_ERROR ||
+        listen(cast.listen_sock, 1) == SOCKET_ERROR) {
+        closesocket(cast.listen_sock);
+        WSACleanup();
+        return false;
+    }
+
+    // Accepts happen opportunistically on the render thread each frame
+    unsigned long nonblock = 1;
+    ioctlsocket(cast.listen_sock, FIONBIO, &nonblock);
+
+    cast.shadow = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    cast.buf = (char*)malloc(CAST_BUF_SIZE);
+    cast.listening = (cast.shadow && cast.buf);
+    return cast.listening;
+}
+
+// Keyframe: the whole frame as runs of identical cells. Sent on connect
+// and after any send hiccup, so the viewer never needs history.
+static int Cast_EncodeKey(CHAR_INFO* frame, CastHeader* hdr) {
+    int len = 0, runs = 0;
+    int total = SCREEN_WIDTH * SCREEN_HEIGHT;
+
+    for (int i = 0; i < total; ) {
+        int run = 1;
+        while (i + run < total && run < 0xFFFF &&
+               frame[i + run].Char.UnicodeChar == frame[i].Char.UnicodeChar &&
+               frame[i + run].Attributes == frame[i].Attributes) run++;
+
+        unsigned short count = (unsigned short)run;
+        CastCell cell = { frame[i].Char.UnicodeChar, frame[i].Attributes };
+        memcpy(cast.buf + len, &count, sizeof(count)); len += sizeof(count);
+        memcpy(cast.buf + len, &cell, sizeof(cell));   len += sizeof(cell);
+        runs++;
+        i += run;
+    }
+
+    hdr->type = CAST_MSG_KEY;
+    hdr->count = (unsigned short)runs;
+    return len;
+}
+
+// Delta: the same dirty-span walk the console diff does, but against the
+// viewer's shadow. Each span is {offset, count, cells...}.
+static int Cast_EncodeDelta(CHAR_INFO* frame, CastHeader* hdr) {
+    int len = 0, spans = 0;
+
+    for (int y = 0; y < SCREEN_HEIGHT; y++) {
+        CHAR_INFO* cur_row = frame + Screen_Index(0, y);
+        CHAR_INFO* old_row = cast.shadow + Screen_Index(0, y);
+        if (memcmp(cur_row, old_row, sizeof(CHAR_INFO) * SCREEN_WIDTH) == 0) continue;
+
+        int x = 0;
+        while (x < SCREEN_WIDTH) {
+            if (cur_row[x].Char.UnicodeChar == old_row[x].Char.UnicodeChar &&
+                cur_row[x].Attributes == old_row[x].Attributes) {
+                x++;
+                continue;
+            }
+            int start = x;
+            int end = x;
+            int gap = 0;
+            while (x < SCREEN_WIDTH && gap <= 4) { // Same coalescing as the console path
+                if (cur_row[x].Char.UnicodeChar != old_row[x].Char.UnicodeChar ||
+                    cur_row[x].Attributes != old_row[x].Attributes) {
+                    end = x;
+                    gap = 0;
+                } else {
+                    gap++;
+                }
+                x++;
+            }
+
+            unsigned short offset = (unsigned short)(y * SCREEN_WIDTH + start);
+            unsigned short count = (unsigned short)(end - start + 1);
+            memcpy(cast.buf + len, &offset, sizeof(offset)); len += sizeof(offset);
+            memcpy(cast.buf + len, &count, sizeof(count));   len += sizeof(count);
+            for (int i = start; i <= end; i++) {
+                CastCell cell = { cur_row[i].Char.UnicodeChar, cur_row[i].Attributes };
+                memcpy(cast.buf + len, &cell, sizeof(cell)); len += sizeof(cell);
             }
+            spans++;
         }
+    }
+
+    hdr->type = CAST_MSG_DELTA;
+    hdr->count = (unsigned short)spans;
+    return len;
+}
+
+// Render thread, once per presented frame: accept a waiting viewer, diff
+// the frame against what they show, and send the (usually tiny) message.
+void Cast_PublishFrame(CHAR_INFO* frame) {
+    if (!cast.client_valid) {
+        cast.client = accept(cast.listen_sock, NULL, NULL);
+        if (cast.client == INVALID_SOCKET) return; // Nobody watching
+
+        // Wedged viewers get dropped, not waited on; disable Nagle so
+        // span-sized messages leave immediately
+        DWORD timeout = CAST_SEND_TIMEOUT;
+        int nodelay = 1;
+        setsockopt(cast.client, SOL_SOCKET, SO_SNDTIMEO, (const char*)&timeout, sizeof(timeout));
+        setsockopt(cast.client, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+        cast.client_valid = true;
+        cast.key_pending = true;
+    }
+
+    CastHeader hdr;
+    hdr.magic = CAST_MAGIC;
+    int len = cast.key_pending ? Cast_EncodeKey(frame, &hdr)
+                               : Cast_EncodeDelta(frame, &hdr);
+    hdr.size = (unsigned int)len;
 
-        // 5. Draw UI / HUD
-        char ui[128];
-        sprintf(ui, " SCORE: %d | COMBO: x%d | DASH: %s ", 
-            g.score, g.combo_multiplier, g.is_dashing ? "ON" : "OFF");
-        Render_String(2, 0, ui, COL_BLACK | (COL_WHITE << 4));
+    // Empty deltas are skipped entirely — an idle menu costs zero bytes
+    if (hdr.type == CAST_MSG_DELTA && hdr.count == 0) return;
 
-        // Combo Bar visual
-        if (g.combo_multiplier > 1) {
-            for(int k=0; k<g.combo_timer/2; k++) 
-                Render_Char(2 + k, 1, 0x2580, COL_YELLOW);
+    if (!Cast_SendAll(cast.client, (const char*)&hdr, sizeof(hdr)) ||
+        !Cast_SendAll(cast.client, cast.buf, len)) {
+        closesocket(cast.client);
+        cast.client_valid = false;
+        cast.key_pending = true; // Resync whoever connects next
+        return;
+    }
+
+    cast.key_pending = false;
+    memcpy(cast.shadow, frame, sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+}
+
+// The bundled viewer: connect, then push every decoded frame through the
+// normal Renderer pipeline (mailbox, diffing console writes, VT backend —
+// all of it works unchanged with the feed as its input).
+int Cast_ViewerRun(const char* ip) {
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return 1;
+
+    SOCKET sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == INVALID_SOCKET) { WSACleanup(); return 1; }
+
+    struct sockaddr_in peer;
+    memset(&peer, 0, sizeof(peer));
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(CAST_PORT);
+    peer.sin_addr.s_addr = inet_addr(ip);
+    if (connect(sock, (struct sockaddr*)&peer, sizeof(peer)) == SOCKET_ERROR) {
+        printf("No broadcast at %s:%d\n", ip, CAST_PORT);
+        closesocket(sock);
+        WSACleanup();
+        return 1;
+    }
+    int nodelay = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&nodelay, sizeof(nodelay));
+    DWORD poll_ms = CAST_RECV_POLL_MS; // Wake to poll ESC while the feed is idle
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char*)&poll_ms, sizeof(poll_ms));
+
+    Engine_Initialize();
+
+    // Accumulated view of the feed; deltas patch it in place
+    int total = SCREEN_WIDTH * SCREEN_HEIGHT;
+    CHAR_INFO* view = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * total);
+    char* payload = (char*)malloc(CAST_BUF_SIZE);
+    for (int i = 0; i < total; i++) {
+        view[i].Char.UnicodeChar = L' ';
+        view[i].Attributes = COL_BLACK;
+    }
+
+    while (g.is_running && !Cast_ViewerQuitKey()) {
+        CastHeader hdr;
+        if (!Cast_RecvAll(sock, (char*)&hdr, sizeof(hdr))) break; // Feed ended
+        if (hdr.magic != CAST_MAGIC || hdr.size > CAST_BUF_SIZE) break;
+        if (!Cast_RecvAll(sock, payload, (int)hdr.size)) break;
+
+        // Decode defensively: counts in the payload are untrusted, so
+        // every read is checked against the received size — a message
+        // whose runs/spans overrun it is treated like a closed feed
+        const char* p = payload;
+        const char* end = payload + hdr.size;
+        bool malformed = false;
+        if (hdr.type == CAST_MSG_KEY) {
+            int i = 0;
+            for (int run = 0; run < hdr.count && i < total; run++) {
+                unsigned short count;
+                CastCell cell;
+                if (end - p < (int)(sizeof(count) + sizeof(cell))) { malformed = true; break; }
+                memcpy(&count, p, sizeof(count)); p += sizeof(count);
+                memcpy(&cell, p, sizeof(cell));   p += sizeof(cell);
+                for (int k = 0; k < count && i < total; k++, i++) {
+                    view[i].Char.UnicodeChar = cell.ch;
+                    view[i].Attributes = cell.attr;
+                }
+            }
+        } else {
+            for (int s = 0; s < hdr.count; s++) {
+                unsigned short offset, count;
+                if (end - p < (int)(sizeof(offset) + sizeof(count))) { malformed = true; break; }
+                memcpy(&offset, p, sizeof(offset)); p += sizeof(offset);
+                memcpy(&count, p, sizeof(count));   p += sizeof(count);
+                if (end - p < (int)(count * sizeof(CastCell))) { malformed = true; break; }
+                for (int k = 0; k < count; k++) {
+                    CastCell cell;
+                    memcpy(&cell, p, sizeof(cell)); p += sizeof(cell);
+                    int i = offset + k;
+                    if (i < total) {
+                        view[i].Char.UnicodeChar = cell.ch;
+                        view[i].Attributes = cell.attr;
+                    }
+                }
+            }
         }
+        if (malformed) break;
+
+        // Hand the frame to the render thread like any drawn frame
+        memcpy(r.pixel_data, view, sizeof(CHAR_INFO) * total);
+        Render_Submit();
+    }
+
+    free(view);
+    free(payload);
+    closesocket(sock);
+    WSACleanup();
+    Engine_Shutdown();
+    return 0;
+}
 
-        // Start Prompt
-        if (!g.has_started) {
-            Render_String(SCREEN_WIDTH/2 - 12, SCREEN_HEIGHT/2 - 5, "PRESS ARROWS TO START", COL_WHITE | FOREGROUND_INTENSITY);
+void Cast_Shutdown() {
+    if (!cast.listening) return;
+    if (cast.client_valid) closesocket(cast.client);
+    closesocket(cast.listen_sock);
+    WSACleanup();
+    free(cast.shadow);
+    free(cast.buf);
+    cast.listening = false;
+    cast.client_valid = false;
+}
+
+// ======================================================================================
+// BENCHMARK HARNESS
+// ======================================================================================
+
+// Tick latency histogram, 1us buckets (last bucket is overflow)
+#define BENCH_HIST_SIZE 8192
+
+// Headless boot shared by --bench, --stress and --replay: frame memory
+// only, no console handles, no threads. Seed policy is the caller's —
+// the harnesses pin a fixed one, playback restores the recorded one.
+static void Bench_BootHeadless() {
+    r.headless = true;
+    for (int i = 0; i < 3; i++) {
+        r.frames[i] = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        memset(r.frames[i], 0, sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+    }
+    r.pixel_data = r.frames[0];
+    r.background = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * ARENA_CELLS);
+    for (int i = 0; i < 2; i++) {
+        r.shadow_data[i] = (CHAR_INFO*)malloc(sizeof(CHAR_INFO) * SCREEN_WIDTH * SCREEN_HEIGHT);
+        r.shadow_valid[i] = false;
+    }
+
+    // --vt combines with any headless flag: presents still compose into
+    // vt_buf (nothing is written), so bytes-per-frame measures the VT stream
+    if (r.use_vt) r.vt_buf = (char*)malloc(VT_BUF_SIZE);
+
+    g.is_running = true;
+    Arena_CreateAll();
+    Snake_AllocBodies();
+    g.scene = SCENE_GAME;
+}
+
+static void Bench_FreeHeadless() {
+    for (int i = 0; i < 3; i++) free(r.frames[i]);
+    free(r.background);
+    free(r.shadow_data[0]);
+    free(r.shadow_data[1]);
+    free(r.vt_buf); // NULL unless --vt
+}
+
+// Greedy bot: head toward the food on the dominant axis, never reverse,
+// fall back to any non-blocked direction. Good enough to keep long runs alive.
+Vec2 Benchmark_BotDir() {
+    Vec2 head = Snake_Segment(0);
+    Vec2 tail = Snake_Segment(g.snake.length - 1);
+    int dx = g.food.x - head.x;
+    int dy = g.food.y - head.y;
+
+    Vec2 cands[4];
+    Vec2 step_x = { (dx >= 0) ? 1 : -1, 0 };
+    Vec2 step_y = { 0, (dy >= 0) ? 1 : -1 };
+    if (abs(dx) >= abs(dy)) { cands[0] = step_x; cands[1] = step_y; }
+    else                    { cands[0] = step_y; cands[1] = step_x; }
+    cands[2] = (Vec2){ -cands[1].x, -cands[1].y };
+    cands[3] = (Vec2){ -cands[0].x, -cands[0].y };
+
+    for (int i = 0; i < 4; i++) {
+        Vec2 c = cands[i];
+        if (c.x == -g.snake.dir.x && c.y == -g.snake.dir.y) continue; // No 180s
+        int nx = head.x + c.x, ny = head.y + c.y;
+        if (nx < 0 || nx >= ARENA_WIDTH || ny < 0 || ny >= ARENA_HEIGHT) continue;
+        if (Grid_IsBlocked(nx, ny) && (nx != tail.x || ny != tail.y)) continue;
+        return c;
+    }
+    return g.snake.dir; // Boxed in — let the collision end the run
+}
+
+void Benchmark_Run(long long ticks) {
+    Bench_BootHeadless();
+
+    // Fixed seed so runs are comparable across builds; flagging the replay
+    // system as "playing" keeps Game_Reset from reseeding off the clock
+    replay.playing = true;
+    replay.seed = 12345;
+    g.mode = MODE_CLASSIC;
+    Game_Reset();
+    g.has_started = true;
+
+    static unsigned int hist[BENCH_HIST_SIZE];
+    memset(hist, 0, sizeof(hist));
+
+    long long deaths = 0;
+    LARGE_INTEGER run_start, t0, t1;
+    QueryPerformanceCounter(&run_start);
+
+    for (long long t = 0; t < ticks; t++) {
+        QueryPerformanceCounter(&t0);
+        Arena_Reset(&arena_frame); // Stands in for the per-frame reset
+
+        // Scripted input, one full simulated frame: logic + draw + present
+        Vec2 want = Benchmark_BotDir();
+        if (want.x != g.snake.dir.x || want.y != g.snake.dir.y) Input_Enqueue(want);
+        Game_UpdateFixed();
+        Particles_Update();
+
+        if (g.scene == SCENE_GAMEOVER) {
+            deaths++;
+            g.scene = SCENE_GAME;
+            Game_Reset();
+            g.has_started = true;
         }
 
-        // Debug Overlay
-        if (g.debug_mode) {
-            char dbg[64];
-            sprintf(dbg, "FPS: %.0f | X:%d Y:%d", g.fps, g.snake.body[0].x, g.snake.body[0].y);
-            Render_String(SCREEN_WIDTH - 25, 0, dbg, COL_GREEN);
+        Game_Draw();
+        Render_Present(r.pixel_data);
+
+        QueryPerformanceCounter(&t1);
+        long long us = (t1.QuadPart - t0.QuadPart) * 1000000 / perf_freq.QuadPart;
+        if (us >= BENCH_HIST_SIZE) us = BENCH_HIST_SIZE - 1;
+        hist[us]++;
+    }
+
+    LARGE_INTEGER run_end;
+    QueryPerformanceCounter(&run_end);
+    double elapsed = (double)(run_end.QuadPart - run_start.QuadPart) / perf_freq.QuadPart;
+
+    // p99 from the histogram
+    long long p99_rank = ticks - ticks / 100;
+    long long seen = 0;
+    int p99_us = BENCH_HIST_SIZE - 1;
+    for (int i = 0; i < BENCH_HIST_SIZE; i++) {
+        seen += hist[i];
+        if (seen >= p99_rank) { p99_us = i; break; }
+    }
+
+    printf("Benchmark: %lld ticks in %.3fs (%.0f ticks/sec)\n", ticks, elapsed, ticks / elapsed);
+    printf("  p99 tick latency : %d us\n", p99_us);
+    printf("  bytes per frame  : %.1f (console payload, diffed)\n", (double)r.bytes_written / ticks);
+    printf("  bot deaths       : %lld | final score: %d | snake length: %d\n", deaths, g.score, g.snake.length);
+
+    Bench_FreeHeadless();
+}
+
+// --- Stress scenarios (--stress <name>) -----------------------------------------------
+// Release gate built on the headless harness: each scenario constructs its
+// worst-case board state directly instead of waiting for the bot to reach
+// it, runs thousands of ticks, and fails the process if tick latency blows
+// its budget or anything fell back to the heap (the arenas' fail counters
+// stay at zero on a healthy frame path).
+
+// Re-mark the player's cells and re-draw the food after a stage rewrote
+// the map: Level_Validate republished the pool as if the board were empty
+static void Stress_ReoccupySnake() {
+    for (int i = 0; i < g.snake.length; i++) {
+        Vec2 seg = Snake_Segment(i);
+        Grid_Occupy(seg.x, seg.y);
+    }
+    Grid_RandomFreeCell(&g.food);
+}
+
+// Brick in everything outside a small pocket around the spawn, then
+// republish the pool. Food placement must stay O(1) with only a couple
+// hundred free cells, and the camera window is solid wall glyphs.
+static void Stress_StageFullBoard() {
+    int cx = ARENA_WIDTH / 2, cy = ARENA_HEIGHT / 2;
+    for (int y = 1; y < ARENA_HEIGHT - 1; y++)
+        for (int x = 1; x < ARENA_WIDTH - 1; x++)
+            if (abs(x - cx) > 12 || abs(y - cy) > 5) Map_Set(x, y, 1);
+    Level_Validate(cx, cy);
+    Render_BakeBackground();
+    Stress_ReoccupySnake();
+}
+
+// Longest body the interior can hold, laid out boustrophedon so every
+// consecutive pair stays adjacent. Worst case for the ring walk, the
+// run-batched body draw and the per-move occupancy updates.
+static void Stress_StageMaxSnake() {
+    Snake* s = &g.snake;
+    int margin = 2;
+    int w = ARENA_WIDTH - 2 * margin;
+    int rows = (ARENA_HEIGHT - 2 * margin) * 9 / 10;
+    int len = w * rows;
+    if (len > MAX_SNAKE_LEN - 2) len = MAX_SNAKE_LEN - 2;
+
+    s->head = 0;
+    s->length = len;
+    s->grow_pending = 0;
+    for (int i = 0; i <= len; i++) { // One past the tail, for interpolation
+        int row = i / w, col = i % w;
+        s->body[i].x = margin + ((row & 1) ? (w - 1 - col) : col);
+        s->body[i].y = margin + row;
+    }
+    s->dir = (Vec2){ s->body[0].x - s->body[1].x, s->body[0].y - s->body[1].y };
+
+    for (int i = 0; i < len; i++) Grid_Occupy(s->body[i].x, s->body[i].y);
+    Grid_RandomFreeCell(&g.food);
+}
+
+// Eight times the shipped wall density, so every bot death re-runs
+// generation plus the full flood validation under that load.
+static void Stress_StageObstacleDense() {
+    int count = 160 * (ARENA_CELLS / (SCREEN_WIDTH * SCREEN_HEIGHT));
+    for (int i = 0; i < count; i++) {
+        int w = 2 + Rng_Range(&g.rng_world, 8);
+        int h = 2 + Rng_Range(&g.rng_world, 5);
+        int x = 2 + Rng_Range(&g.rng_world, ARENA_WIDTH - w - 4);
+        int y = 2 + Rng_Range(&g.rng_world, ARENA_HEIGHT - h - 4);
+        for (int yy = y; yy < y + h; yy++)
+            for (int xx = x; xx < x + w; xx++)
+                Map_Set(xx, yy, 1);
+    }
+    // Keep the spawn block itself clear, as generation does
+    int cx = ARENA_WIDTH / 2, cy = ARENA_HEIGHT / 2;
+    for (int yy = cy - 5; yy <= cy + 5; yy++)
+        for (int xx = cx - 5; xx <= cx + 5; xx++)
+            Map_Set(xx, yy, 0);
+    Level_Validate(cx, cy);
+    Render_BakeBackground();
+    Stress_ReoccupySnake();
+}
+
+// Keep the SoA system pinned at MAX_PARTICLES live every tick: worst case
+// for the SIMD update, the expiry compaction and the per-particle draw
+static void Stress_TickParticleStorm() {
+    while (g.particles.live_count < MAX_PARTICLES) {
+        int before = g.particles.live_count;
+        int x = 1 + Rng_Range(&g.rng_fx, ARENA_WIDTH - 2);
+        int y = 1 + Rng_Range(&g.rng_fx, ARENA_HEIGHT - 2);
+        Particles_Spawn(x, y, 256, COL_YELLOW);
+        if (g.particles.live_count == before) break; // Arena degrade — counter flags it
+    }
+}
+
+typedef struct {
+    const char* name;
+    GameMode mode;
+    void (*stage)();       // Rebuilds the worst case after every reset
+    void (*tick)();        // Per-tick pressure, before the frame work
+    int p99_budget_us;     // Latency gate on the measured histogram
+} StressScenario;
+
+static const StressScenario stress_scenarios[] = {
+    { "full-board",     MODE_CLASSIC,   Stress_StageFullBoard,     NULL,                     2000 },
+    { "max-snake",      MODE_CLASSIC,   Stress_StageMaxSnake,      NULL,                     4000 },
+    { "particle-storm", MODE_CLASSIC,   NULL,                      Stress_TickParticleStorm, 4000 },
+    { "obstacle-dense", MODE_OBSTACLES, Stress_StageObstacleDense, NULL,                     4000 },
+};
+
+int Stress_Run(const char* name, long long ticks) {
+    const StressScenario* sc = NULL;
+    int n_scenarios = (int)(sizeof(stress_scenarios) / sizeof(stress_scenarios[0]));
+    for (int i = 0; i < n_scenarios; i++)
+        if (strcmp(stress_scenarios[i].name, name) == 0) sc = &stress_scenarios[i];
+    if (!sc) {
+        printf("Unknown stress scenario '%s'. Available:", name);
+        for (int i = 0; i < n_scenarios; i++) printf(" %s", stress_scenarios[i].name);
+        printf("\n");
+        return 2;
+    }
+
+    Bench_BootHeadless();
+    replay.playing = true; // Fixed seed, comparable runs — as in Benchmark_Run
+    replay.seed = 12345;
+    g.mode = sc->mode;
+    Game_Reset();
+    g.has_started = true;
+    if (sc->stage) sc->stage();
+
+    // Baseline the counters after boot: from here on, every transient
+    // byte must come out of the arenas
+    arena_frame.fail_count = 0;
+    arena_level.fail_count = 0;
+
+    static unsigned int hist[BENCH_HIST_SIZE];
+    memset(hist, 0, sizeof(hist));
+
+    long long deaths = 0, measured = 0;
+    LARGE_INTEGER t0, t1;
+
+    for (long long t = 0; t < ticks; t++) {
+        QueryPerformanceCounter(&t0);
+        Arena_Reset(&arena_frame);
+
+        if (sc->tick) sc->tick();
+        Vec2 want = Benchmark_BotDir();
+        if (want.x != g.snake.dir.x || want.y != g.snake.dir.y) Input_Enqueue(want);
+        Game_UpdateFixed();
+        Particles_Update();
+
+        if (g.scene == SCENE_GAMEOVER) {
+            // Restaging is harness work, not frame path — rebuild the
+            // worst case and leave this tick out of the histogram
+            deaths++;
+            g.scene = SCENE_GAME;
+            Game_Reset();
+            g.has_started = true;
+            if (sc->stage) sc->stage();
+            continue;
         }
+
+        Game_Draw();
+        Render_Present(r.pixel_data);
+
+        QueryPerformanceCounter(&t1);
+        long long us = (t1.QuadPart - t0.QuadPart) * 1000000 / perf_freq.QuadPart;
+        if (us >= BENCH_HIST_SIZE) us = BENCH_HIST_SIZE - 1;
+        hist[us]++;
+        measured++;
+    }
+
+    long long p99_rank = measured - measured / 100;
+    long long seen = 0;
+    int p99_us = BENCH_HIST_SIZE - 1;
+    for (int i = 0; i < BENCH_HIST_SIZE; i++) {
+        seen += hist[i];
+        if (seen >= p99_rank) { p99_us = i; break; }
+    }
+
+    bool lat_ok = p99_us <= sc->p99_budget_us;
+    bool mem_ok = arena_frame.fail_count == 0 && arena_level.fail_count == 0;
+
+    printf("Stress '%s': %lld ticks (%lld measured), %lld deaths\n", sc->name, ticks, measured, deaths);
+    printf("  p99 tick latency : %d us (budget %d) %s\n",
+           p99_us, sc->p99_budget_us, lat_ok ? "ok" : "FAIL");
+    printf("  arena fallbacks  : frame %zu, level %zu %s\n",
+           arena_frame.fail_count, arena_level.fail_count, mem_ok ? "ok" : "FAIL");
+    printf("  frame arena peak : %zu / %zu bytes | level %zu / %zu\n",
+           arena_frame.high_water, arena_frame.cap, arena_level.high_water, arena_level.cap);
+
+    Bench_FreeHeadless();
+    if (!lat_ok || !mem_ok) {
+        printf("STRESS FAIL: '%s' regressed — do not ship.\n", sc->name);
+        return 1;
     }
+    printf("STRESS PASS\n");
+    return 0;
 }
 
 // ======================================================================================
 // PERSISTENCE
 // ======================================================================================
 
+// First index whose score is strictly below the given one — the insert
+// position for a new entry (it ranks behind equal older ones)
+static int ScoreIndex_LowerBound(int score) {
+    int lo = 0, hi = scores.count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (scores.entries[mid].score >= score) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+static void ScoreIndex_Insert(const ScoreEntry* entry) {
+    if (scores.count == scores.cap) {
+        scores.cap = scores.cap ? scores.cap * 2 : 256;
+        scores.entries = (ScoreEntry*)realloc(scores.entries, sizeof(ScoreEntry) * scores.cap);
+    }
+    int at = ScoreIndex_LowerBound(entry->score);
+    memmove(scores.entries + at + 1, scores.entries + at,
+            sizeof(ScoreEntry) * (scores.count - at));
+    scores.entries[at] = *entry;
+    scores.count++;
+    scores.version++;
+}
+
+static int ScoreIndex_CmpDesc(const void* a, const void* b) {
+    return ((const ScoreEntry*)b)->score - ((const ScoreEntry*)a)->score;
+}
+
+const ScoreEntry* Score_Top(int i) {
+    return (i >= 0 && i < scores.count) ? &scores.entries[i] : NULL;
+}
+
+int Score_RankOf(int score) {
+    // Rank = entries strictly above, plus one
+    int lo = 0, hi = scores.count;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (scores.entries[mid].score > score) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo + 1;
+}
+
+const ScoreEntry* Score_BestOf(const char* name) {
+    // Sorted descending, so the first name match is that player's best
+    for (int i = 0; i < scores.count; i++) {
+        if (strcmp(scores.entries[i].name, name) == 0) return &scores.entries[i];
+    }
+    return NULL;
+}
+
+// Reset the file to an empty v2 layout (fresh install, or a file whose
+// header/layout we don't recognize — refusing to guess beats misreading)
+static void Score_InitFile() {
+    SaveHeader h = { SAVE_MAGIC, SAVE_VERSION, sizeof(ScoreEntry), 0 };
+    DWORD written;
+    SetFilePointer(save.hFile, 0, NULL, FILE_BEGIN);
+    WriteFile(save.hFile, &h, sizeof(h), &written, NULL);
+    SetEndOfFile(save.hFile);
+    save.base_count = 0;
+    save.journal_count = 0;
+}
+
+// Writer thread: owns every byte written to SAVE_FILE after startup.
+// Sleeps on the work event, drains the ring, appends each record at
+// EOF. The main thread only ever posts to the ring, so a stalled disk
+// stalls this thread and nothing else.
+DWORD WINAPI Score_WriterProc(LPVOID param) {
+    (void)param;
+    for (;;) {
+        WaitForSingleObject(save.hWorkEvent, INFINITE);
+
+        while (save.q_head != save.q_tail) {
+            ScoreEntry e = save.queue[save.q_head];
+            MemoryBarrier(); // Read the payload before releasing the slot
+            save.q_head = (save.q_head + 1) % SAVE_QUEUE_SIZE;
+
+            DWORD written;
+            SetFilePointer(save.hFile, 0, NULL, FILE_END);
+            WriteFile(save.hFile, &e, sizeof(e), &written, NULL);
+            save.journal_count++;
+        }
+
+        if (save.quit) return 0;
+    }
+}
+
 void Score_Load() {
-    FILE* f = fopen(SAVE_FILE, "rb");
-    if (f) {
-        fread(leaderboard, sizeof(ScoreEntry), MAX_SCORES, f);
-        fclose(f);
-    } else {
-        memset(leaderboard, 0, sizeof(leaderboard));
+    scores.count = 0;
+    save.base_count = 0;
+    save.journal_count = 0;
+    save.q_head = save.q_tail = 0;
+    save.quit = 0;
+
+    // The handle stays open for the life of the process: journal appends
+    // go through it, and compaction rewrites through it on shutdown
+    save.hFile = CreateFileA(SAVE_FILE, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ,
+                             NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (save.hFile == INVALID_HANDLE_VALUE) return;
+
+    // Start the background writer as soon as the handle is live: the
+    // fresh-install and bad-header paths below return early, and scores
+    // from those very runs still have to reach disk
+    save.hWorkEvent = CreateEventA(NULL, FALSE, FALSE, NULL); // Auto-reset
+    save.hThread = CreateThread(NULL, 0, Score_WriterProc, NULL, 0, NULL);
+
+    DWORD size = GetFileSize(save.hFile, NULL);
+    if (size < sizeof(SaveHeader)) { Score_InitFile(); return; }
+
+    // Map the whole file read-only: entries are walked in place with no
+    // intermediate read buffer, which stays cheap as the journal grows
+    HANDLE hMap = CreateFileMappingA(save.hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!hMap) { Score_InitFile(); return; }
+    const unsigned char* view = (const unsigned char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(hMap); Score_InitFile(); return; }
+
+    const SaveHeader* h = (const SaveHeader*)view;
+    if (h->magic != SAVE_MAGIC || h->version != SAVE_VERSION ||
+        h->entry_size != sizeof(ScoreEntry)) {
+        UnmapViewOfFile(view);
+        CloseHandle(hMap);
+        Score_InitFile();
+        return;
+    }
+
+    // Everything past the header is entries: base region first, then
+    // journal records appended by previous sessions that never compacted
+    unsigned int total = (size - sizeof(SaveHeader)) / sizeof(ScoreEntry);
+    save.base_count = (h->entry_count < total) ? h->entry_count : total;
+    save.journal_count = total - save.base_count;
+
+    // Bulk-build the index: copy every record straight out of the
+    // mapping, then one sort — cheaper than n ranked inserts
+    const ScoreEntry* entries = (const ScoreEntry*)(view + sizeof(SaveHeader));
+    if (total > 0) {
+        if ((int)total > scores.cap) {
+            scores.cap = total;
+            scores.entries = (ScoreEntry*)realloc(scores.entries, sizeof(ScoreEntry) * scores.cap);
+        }
+        memcpy(scores.entries, entries, sizeof(ScoreEntry) * total);
+        scores.count = total;
+        scores.version++;
+        qsort(scores.entries, scores.count, sizeof(ScoreEntry), ScoreIndex_CmpDesc);
     }
+
+    UnmapViewOfFile(view);
+    CloseHandle(hMap);
 }
 
 void Score_Save() {
-    FILE* f = fopen(SAVE_FILE, "wb");
-    if (f) {
-        fwrite(leaderboard, sizeof(ScoreEntry), MAX_SCORES, f);
-        fclose(f);
+    // All I/O happens on the writer thread; this just makes sure it is
+    // awake. Kept for call-site symmetry with Score_Add.
+    if (save.hThread) SetEvent(save.hWorkEvent);
+}
+
+void Score_Compact() {
+    // NULL covers boot paths (e.g. the spectator viewer) that never loaded
+    if (save.hFile == NULL || save.hFile == INVALID_HANDLE_VALUE) return;
+
+    // Stop the writer first: signal quit, wake it, and give it a bounded
+    // window to drain the ring. If the disk has it wedged past that, we
+    // skip compaction — the already-appended journal is still consistent.
+    if (save.hThread) {
+        save.quit = 1;
+        SetEvent(save.hWorkEvent);
+        DWORD waited = WaitForSingleObject(save.hThread, 2000);
+        CloseHandle(save.hThread);
+        CloseHandle(save.hWorkEvent);
+        save.hThread = NULL;
+        if (waited != WAIT_OBJECT_0) {
+            save.hFile = INVALID_HANDLE_VALUE; // Leave the handle to the wedged write
+            return;
+        }
     }
+
+    if (save.journal_count > 0) {
+        // The index already holds every record (base + journal) in rank
+        // order, so compaction is just writing it back under a clean header
+        unsigned int total = scores.count;
+        if (total > SAVE_MAX_ENTRIES) total = SAVE_MAX_ENTRIES;
+
+        DWORD moved;
+        SaveHeader h = { SAVE_MAGIC, SAVE_VERSION, sizeof(ScoreEntry), total };
+        SetFilePointer(save.hFile, 0, NULL, FILE_BEGIN);
+        WriteFile(save.hFile, &h, sizeof(h), &moved, NULL);
+        WriteFile(save.hFile, scores.entries, sizeof(ScoreEntry) * total, &moved, NULL);
+        SetEndOfFile(save.hFile);
+    }
+
+    CloseHandle(save.hFile);
+    save.hFile = INVALID_HANDLE_VALUE;
 }
 
 void Score_Add(const char* name, int score) {
     ScoreEntry entry;
+    memset(&entry, 0, sizeof(entry));
     strncpy(entry.name, name, 15);
     entry.score = score;
     entry.max_combo = 0; // Not currently tracked in UI but stored
 
-    for(int i=0; i<MAX_SCORES; i++) {
-        if(score > leaderboard[i].score) {
-            // Shift lower scores down
-            for(int j=MAX_SCORES-1; j>i; j--) {
-                leaderboard[j] = leaderboard[j-1];
-            }
-            leaderboard[i] = entry;
-            break;
-        }
+    ScoreIndex_Insert(&entry);
+
+    // Every finished run is journaled, not just top-N placements: post
+    // to the writer's ring and wake it. Full ring (16 unflushed entries
+    // against a dead disk) drops the oldest-pending semantics cleanly
+    // by dropping this post rather than blocking the frame.
+    LONG tail = save.q_tail;
+    LONG next = (tail + 1) % SAVE_QUEUE_SIZE;
+    if (next != save.q_head && save.hThread) {
+        save.queue[tail] = entry;
+        MemoryBarrier(); // Payload visible before the index moves
+        save.q_tail = next;
+        SetEvent(save.hWorkEvent);
     }
 }
\ No newline at end of file